@@ -0,0 +1,599 @@
+/****************************************************************************************
+ * File name	: arith.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Arithmetic expansion of $(( expression )) in command arguments. See arith.h
+ *					for the operators supported.
+ *
+ * NOTES		:	Expressions are evaluated as they are parsed, by precedence climbing,
+ *					with no tree built in between. Branches skipped by && || and ?: are
+ *					still parsed, but their assignments and errors are ignored.
+ ****************************************************************************************/
+
+#define _GNU_SOURCE /* setenv() and strndup() */
+
+#include "arith.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#define ARITH_MAX_DEPTH 512 /* nested unary operators and parentheses allowed */
+
+enum arithOperation_e {
+	ARITH_OR, ARITH_AND,
+	ARITH_BITOR, ARITH_BITXOR, ARITH_BITAND,
+	ARITH_EQUAL, ARITH_NOTEQUAL,
+	ARITH_LESS, ARITH_LESSEQUAL, ARITH_GREATER, ARITH_GREATEREQUAL,
+	ARITH_SHIFTLEFT, ARITH_SHIFTRIGHT,
+	ARITH_ADD, ARITH_SUBTRACT,
+	ARITH_MULTIPLY, ARITH_DIVIDE, ARITH_REMAINDER,
+	ARITH_POWER
+};
+
+struct arithOperator_s {
+	const char *symbol;
+	size_t length;
+	int precedence;				/* higher binds tighter */
+	int rightAssociative;
+	enum arithOperation_e operation;
+};
+
+/* symbols come before any shorter symbol they start with, so the longest one matches */
+static const struct arithOperator_s binaryOperators[] = {
+	{ "||", 2, 1, 0, ARITH_OR },
+	{ "&&", 2, 2, 0, ARITH_AND },
+	{ "|", 1, 3, 0, ARITH_BITOR },
+	{ "^", 1, 4, 0, ARITH_BITXOR },
+	{ "&", 1, 5, 0, ARITH_BITAND },
+	{ "==", 2, 6, 0, ARITH_EQUAL },
+	{ "!=", 2, 6, 0, ARITH_NOTEQUAL },
+	{ "<<", 2, 8, 0, ARITH_SHIFTLEFT },
+	{ ">>", 2, 8, 0, ARITH_SHIFTRIGHT },
+	{ "<=", 2, 7, 0, ARITH_LESSEQUAL },
+	{ ">=", 2, 7, 0, ARITH_GREATEREQUAL },
+	{ "<", 1, 7, 0, ARITH_LESS },
+	{ ">", 1, 7, 0, ARITH_GREATER },
+	{ "+", 1, 9, 0, ARITH_ADD },
+	{ "-", 1, 9, 0, ARITH_SUBTRACT },
+	{ "**", 2, 11, 1, ARITH_POWER },
+	{ "*", 1, 10, 0, ARITH_MULTIPLY },
+	{ "/", 1, 10, 0, ARITH_DIVIDE },
+	{ "%", 1, 10, 0, ARITH_REMAINDER },
+	{ NULL, 0, 0, 0, 0 }
+};
+
+struct arithParser_s {
+	const char *position;	/* next character to parse */
+	int evaluate;			/* 0 while parsing a branch whose value is not used */
+	int depth;				/* current nesting of unary operators and parentheses */
+	const char *error;		/* first error found, NULL if none */
+};
+
+struct arithBuffer_s {
+	char *text;
+	size_t length, capacity;
+};
+
+static int parseAssignment(struct arithParser_s *parser, int64_t *value);
+
+
+/********************************************************************************
+ * Function name  : static int arithError(struct arithParser_s *parser, const char *message)
+ *     returns    : -1, for the caller to return
+ *         parser    : parser that found the error
+ *         message   : description of the error
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : record message as the parser's error, unless one is already recorded.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int arithError(struct arithParser_s *parser, const char *message) {
+	if (parser->error == NULL)
+		parser->error = message;
+	return -1;
+}
+
+
+/********************************************************************************
+ * Function name  : static void skipSpaces(struct arithParser_s *parser)
+ *         parser    : parser to advance past any whitespace
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static void skipSpaces(struct arithParser_s *parser) {
+	while (isspace((unsigned char)*parser->position))
+		parser->position++;
+}
+
+
+/********************************************************************************
+ * Function name  : static size_t identifierLength(const char *text)
+ *     returns    : length of the identifier text starts with, 0 if it does not start
+ *                  with one
+ *         text      : expression text
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : identifiers are a letter or underscore followed by letters, digits
+ *                  and underscores, as environment variable names.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static size_t identifierLength(const char *text) {
+	size_t length = 0;
+	if (!isalpha((unsigned char)text[0]) && text[0] != '_')
+		return 0;
+	while (isalnum((unsigned char)text[length]) || text[length] == '_')
+		length++;
+	return length;
+}
+
+
+/********************************************************************************
+ * Function name  : static int applyOperator(struct arithParser_s *parser,
+ *											enum arithOperation_e operation,
+ *											int64_t left, int64_t right, int64_t *result)
+ *     returns    : zero on success, -1 on error
+ *         parser    : parser evaluating the expression
+ *         operation : binary operation to apply
+ *         left      : left hand operand
+ *         right     : right hand operand
+ *         result    : receives left operation right
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          : + - * ** and << are done unsigned so that overflow wraps rather
+ *                  than being undefined. shift counts are taken modulo 64.
+ ********************************************************************************/
+static int applyOperator(struct arithParser_s *parser, enum arithOperation_e operation,
+						 int64_t left, int64_t right, int64_t *result) {
+	if (!parser->evaluate) {
+		*result = 0;
+		return 0;
+	}
+	switch (operation) {
+		case ARITH_OR:				*result = left || right; break;
+		case ARITH_AND:				*result = left && right; break;
+		case ARITH_BITOR:			*result = left | right; break;
+		case ARITH_BITXOR:			*result = left ^ right; break;
+		case ARITH_BITAND:			*result = left & right; break;
+		case ARITH_EQUAL:			*result = left == right; break;
+		case ARITH_NOTEQUAL:		*result = left != right; break;
+		case ARITH_LESS:			*result = left < right; break;
+		case ARITH_LESSEQUAL:		*result = left <= right; break;
+		case ARITH_GREATER:			*result = left > right; break;
+		case ARITH_GREATEREQUAL:	*result = left >= right; break;
+		case ARITH_SHIFTLEFT:		*result = (int64_t)((uint64_t)left << (right & 63)); break;
+		case ARITH_SHIFTRIGHT:		*result = left >> (right & 63); break;
+		case ARITH_ADD:				*result = (int64_t)((uint64_t)left+(uint64_t)right); break;
+		case ARITH_SUBTRACT:		*result = (int64_t)((uint64_t)left-(uint64_t)right); break;
+		case ARITH_MULTIPLY:		*result = (int64_t)((uint64_t)left*(uint64_t)right); break;
+		case ARITH_DIVIDE:
+		case ARITH_REMAINDER:
+			if (right == 0)
+				return arithError(parser, "division by zero");
+			/* the one quotient that does not fit in 64 bits */
+			if (left == INT64_MIN && right == -1)
+				*result = operation == ARITH_DIVIDE ? INT64_MIN : 0;
+			else
+				*result = operation == ARITH_DIVIDE ? left/right : left%right;
+			break;
+		case ARITH_POWER: {
+			if (right < 0)
+				return arithError(parser, "negative exponent");
+			uint64_t base = (uint64_t)left, power = 1;
+			for (; right > 0; right >>= 1) {
+				if (right & 1)
+					power *= base;
+				base *= base;
+			}
+			*result = (int64_t)power;
+			break;
+		}
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int parsePrimary(struct arithParser_s *parser, int64_t *value)
+ *     returns    : zero on success, -1 on error
+ *         parser    : parser positioned at a number, variable or parenthesis
+ *         value     : receives the value parsed
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : parse a number (decimal, 0x hex or 0 octal), a variable, or a
+ *                  parenthesised expression.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int parsePrimary(struct arithParser_s *parser, int64_t *value) {
+	skipSpaces(parser);
+	const char *start = parser->position;
+	size_t length;
+
+	if (*start == '(') {
+		if (++parser->depth > ARITH_MAX_DEPTH)
+			return arithError(parser, "expression nested too deeply");
+		parser->position++;
+		int status = parseAssignment(parser, value);
+		parser->depth--;
+		if (status != 0)
+			return -1;
+		skipSpaces(parser);
+		if (*parser->position != ')')
+			return arithError(parser, "missing )");
+		parser->position++;
+		return 0;
+	}
+	else if (isdigit((unsigned char)*start)) {
+		char *end;
+		errno = 0;
+		*value = (int64_t)strtoull(start, &end, 0);
+		if (errno == ERANGE)
+			return arithError(parser, "number too large");
+		if (isalnum((unsigned char)*end) || *end == '_')
+			return arithError(parser, "invalid number");
+		parser->position = end;
+		return 0;
+	}
+	else if ((length = identifierLength(start)) > 0) {
+		parser->position += length;
+		char *name = strndup(start, length);
+		if (name == NULL)
+			return arithError(parser, "out of memory");
+		const char *variable = getenv(name);
+		free(name);
+		*value = 0;
+		if (variable == NULL || *variable == '\0')
+			return 0;
+		char *end;
+		errno = 0;
+		*value = strtoll(variable, &end, 0);
+		while (isspace((unsigned char)*end))
+			end++;
+		/* a skipped branch may name a variable that only holds a number when taken */
+		if ((errno == ERANGE || *end != '\0' || end == variable) && parser->evaluate)
+			return arithError(parser, "variable is not a number");
+		return 0;
+	}
+	return arithError(parser, *start == '\0' ? "expression incomplete" : "syntax error");
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseUnary(struct arithParser_s *parser, int64_t *value)
+ *     returns    : zero on success, -1 on error
+ *         parser    : parser positioned at an operand
+ *         value     : receives the value parsed
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : parse any unary + - ! ~ operators and the operand they apply to.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int parseUnary(struct arithParser_s *parser, int64_t *value) {
+	skipSpaces(parser);
+	char operator = *parser->position;
+	if (operator != '+' && operator != '-' && operator != '!' && operator != '~')
+		return parsePrimary(parser, value);
+
+	if (++parser->depth > ARITH_MAX_DEPTH)
+		return arithError(parser, "expression nested too deeply");
+	parser->position++;
+	int status = parseUnary(parser, value);
+	parser->depth--;
+	if (status != 0)
+		return -1;
+	if (operator == '-')
+		*value = (int64_t)(0-(uint64_t)*value);
+	else if (operator == '!')
+		*value = !*value;
+	else if (operator == '~')
+		*value = ~*value;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseBinary(struct arithParser_s *parser, int minPrecedence,
+ *											int64_t *value)
+ *     returns    : zero on success, -1 on error
+ *         parser        : parser positioned at an operand
+ *         minPrecedence : loosest binding operator this call may consume
+ *         value         : receives the value parsed
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : precedence climbing. parse an operand, then keep folding in
+ *                  operators of at least minPrecedence, each with a right hand side
+ *                  parsed at the precedence just above its own (or at its own, for
+ *                  right associative **).
+ *
+ * NOTES          : the right hand side of && and || is parsed without evaluation
+ *                  when the left hand side decides the result.
+ ********************************************************************************/
+static int parseBinary(struct arithParser_s *parser, int minPrecedence, int64_t *value) {
+	if (parseUnary(parser, value) != 0)
+		return -1;
+	for (;;) {
+		skipSpaces(parser);
+		const struct arithOperator_s *operator = binaryOperators;
+		while (operator->symbol != NULL && strncmp(parser->position, operator->symbol, operator->length) != 0)
+			operator++;
+		if (operator->symbol == NULL || operator->precedence < minPrecedence)
+			return 0;
+		parser->position += operator->length;
+
+		int evaluate = parser->evaluate;
+		if ((operator->operation == ARITH_AND && *value == 0) || (operator->operation == ARITH_OR && *value != 0))
+			parser->evaluate = 0;
+		int64_t right;
+		int status = parseBinary(parser, operator->precedence+!operator->rightAssociative, &right);
+		parser->evaluate = evaluate;
+		if (status != 0 || applyOperator(parser, operator->operation, *value, right, value) != 0)
+			return -1;
+	}
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseConditional(struct arithParser_s *parser, int64_t *value)
+ *     returns    : zero on success, -1 on error
+ *         parser    : parser positioned at an operand
+ *         value     : receives the value parsed
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : parse condition ? expression : expression, or just a binary
+ *                  expression if no ? follows it.
+ *
+ * NOTES          : only the branch chosen is evaluated.
+ ********************************************************************************/
+static int parseConditional(struct arithParser_s *parser, int64_t *value) {
+	if (parseBinary(parser, 1, value) != 0)
+		return -1;
+	skipSpaces(parser);
+	if (*parser->position != '?')
+		return 0;
+	parser->position++;
+
+	int evaluate = parser->evaluate;
+	int64_t ifTrue, ifFalse;
+	parser->evaluate = evaluate && *value != 0;
+	if (parseAssignment(parser, &ifTrue) != 0)
+		return -1;
+	skipSpaces(parser);
+	if (*parser->position != ':')
+		return arithError(parser, "missing : after ?");
+	parser->position++;
+	parser->evaluate = evaluate && *value == 0;
+	if (parseConditional(parser, &ifFalse) != 0)
+		return -1;
+	parser->evaluate = evaluate;
+	*value = *value ? ifTrue : ifFalse;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseAssignment(struct arithParser_s *parser, int64_t *value)
+ *     returns    : zero on success, -1 on error
+ *         parser    : parser positioned at the start of an expression
+ *         value     : receives the value parsed
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : parse name = expression, setting environment variable name to the
+ *                  value, or a conditional expression if no assignment is found.
+ *
+ * NOTES          : assignment is right associative, so a = b = 1 sets both.
+ ********************************************************************************/
+static int parseAssignment(struct arithParser_s *parser, int64_t *value) {
+	skipSpaces(parser);
+	const char *start = parser->position, *equals = start+identifierLength(start);
+	while (equals > start && isspace((unsigned char)*equals))
+		equals++;
+	if (equals == start || equals[0] != '=' || equals[1] == '=')
+		return parseConditional(parser, value);
+
+	parser->position = equals+1;
+	if (parseAssignment(parser, value) != 0)
+		return -1;
+	if (parser->evaluate) {
+		char number[24];
+		char *name = strndup(start, identifierLength(start));
+		snprintf(number, sizeof(number), "%" PRId64, *value);
+		if (name == NULL || setenv(name, number, 1) != 0) {
+			free(name);
+			return arithError(parser, "cannot set variable");
+		}
+		free(name);
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : int evaluateArithmetic(const char *expression, int64_t *result)
+ *     returns    : zero on success, -1 on error
+ *         expression: NULL terminated expression, without the surrounding $(( ))
+ *         result    : receives the value of expression
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : evaluate expression, carrying out any assignments in it. an empty
+ *                  expression is 0.
+ *
+ * NOTES          : errors are reported on stderr.
+ ********************************************************************************/
+int evaluateArithmetic(const char *expression, int64_t *result) {
+	struct arithParser_s parser = { expression, 1, 0, NULL };
+	*result = 0;
+	skipSpaces(&parser);
+	if (*parser.position == '\0')
+		return 0;
+	if (parseAssignment(&parser, result) == 0) {
+		skipSpaces(&parser);
+		if (*parser.position != '\0')
+			arithError(&parser, "syntax error");
+	}
+	if (parser.error != NULL) {
+		fprintf(stderr, "$((%s)): %s\n", expression, parser.error);
+		return -1;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : size_t arithmeticLength(const char *text)
+ *     returns    : length of the $(( )) expansion text starts with, including the
+ *                  $(( and )), or 0 if text does not start with a complete one
+ *         text      : part of a command line or argument
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : find the )) closing the expansion, skipping over balanced
+ *                  parentheses in between.
+ *
+ * NOTES          : used by interpretCommand() so that an expansion containing spaces
+ *                  stays in one argument.
+ ********************************************************************************/
+size_t arithmeticLength(const char *text) {
+	if (strncmp(text, "$((", 3) != 0)
+		return 0;
+	int depth = 0;
+	for (size_t i = 3; text[i] != '\0'; i++) {
+		if (text[i] == '(') {
+			depth++;
+		}
+		else if (text[i] == ')') {
+			if (depth > 0)
+				depth--;
+			else
+				return text[i+1] == ')' ? i+2 : 0;
+		}
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int appendText(struct arithBuffer_s *buffer, const char *text,
+ *										size_t length)
+ *     returns    : zero on success, -1 if out of memory
+ *         buffer    : buffer to append to, kept NULL terminated
+ *         text      : characters to append
+ *         length    : number of characters of text to append
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int appendText(struct arithBuffer_s *buffer, const char *text, size_t length) {
+	if (buffer->length+length+1 > buffer->capacity) {
+		size_t capacity = (buffer->length+length+1)*2;
+		char *grown = realloc(buffer->text, capacity);
+		if (grown == NULL)
+			return -1;
+		buffer->text = grown;
+		buffer->capacity = capacity;
+	}
+	memcpy(buffer->text+buffer->length, text, length);
+	buffer->length += length;
+	buffer->text[buffer->length] = '\0';
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static char *expandString(const char *argument)
+ *     returns    : malloc'd copy of argument with every $(( )) replaced by its value,
+ *                  or NULL on error
+ *         argument  : NULL terminated text to expand
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : expansions nested inside an expression are expanded first.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static char *expandString(const char *argument) {
+	struct arithBuffer_s buffer = { NULL, 0, 0 };
+	const char *copied = argument, *c = argument;
+	while (*c != '\0') {
+		size_t length = arithmeticLength(c);
+		if (length == 0) {
+			c++;
+			continue;
+		}
+
+		/* expression without the $(( and )) */
+		char *expression = strndup(c+3, length-5), *inner = expression;
+		if (expression != NULL && strstr(expression, "$((") != NULL)
+			inner = expandString(expression);
+		int64_t value;
+		char number[24];
+		int status = inner == NULL ? -1 : evaluateArithmetic(inner, &value);
+		if (inner != expression)
+			free(inner);
+		free(expression);
+		if (status != 0)
+			break;
+		snprintf(number, sizeof(number), "%" PRId64, value);
+		if (appendText(&buffer, copied, c-copied) != 0 || appendText(&buffer, number, strlen(number)) != 0)
+			break;
+		c += length;
+		copied = c;
+	}
+	if (*c == '\0' && appendText(&buffer, copied, c-copied) == 0)
+		return buffer.text;
+	free(buffer.text);
+	return NULL;
+}
+
+
+/********************************************************************************
+ * Function name  : int expandArithmetic(struct command_s *command)
+ *     returns    : zero on success, non-zero on failure
+ *         command   : command whose arguments to expand in place
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : replace every $(( expression )) in command's arguments with the
+ *                  decimal value of expression.
+ *
+ * NOTES          : runs before expandGlobs(), so a * in an expression is never taken for
+ *                  a pattern.
+ ********************************************************************************/
+int expandArithmetic(struct command_s *command) {
+	for (unsigned int i = 0; i < command->argc; i++) {
+		if (strstr(command->argv[i], "$((") == NULL)
+			continue;
+		char *expanded = expandString(command->argv[i]);
+		if (expanded == NULL)
+			return 1;
+		free(command->argv[i]);
+		command->argv[i] = expanded;
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+/****************************************************************************************
+ * File name	: arith.h
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Arithmetic expansion. $(( expression )) in a command argument is replaced
+ *					by the expression's value, evaluated in-process over 64 bit integers.
+ *
+ * NOTES		:	Operators, loosest binding first:
+ *						=  ?:  ||  &&  |  ^  &  == !=  < <= > >=  << >>  + -  * / %  **
+ *						unary + - ! ~  and ( )
+ *					Identifiers name environment variables. unset or empty variables are
+ *					0, and name=expression sets one. + - * and ** wrap on overflow.
+ ****************************************************************************************/
+
+#ifndef _ARITH_H_
+#define _ARITH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "commands.h"
+
+size_t arithmeticLength(const char *text);
+int evaluateArithmetic(const char *expression, int64_t *result);
+int expandArithmetic(struct command_s *command);
+
+#endif
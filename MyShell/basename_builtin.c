@@ -0,0 +1,65 @@
+/****************************************************************************************
+ * File name	: basename_builtin.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Sample loadable builtin. Builds to basename.so, which the shell loads with
+ *
+ *					enable -f ./basename.so basename
+ *
+ *					after which basename runs inside the shell instead of fork()ing 
+ *					/usr/bin/basename.
+ *
+ * NOTES		:	built on its own, as a shared object. a loadable builtin exports
+ *					builtin_<name> with the same signature as the builtins in builtin.c,
+ *					and writes its output to outputFD rather than stdout. it reports failure
+ *					by setting builtinStatus, which the shell exports (it links with -rdynamic).
+ ****************************************************************************************/
+
+#include "builtin.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/********************************************************************************
+ * Function name  : void builtin_basename(int argc, char **argv, int inputFD, int outputFD)
+ *             argc  : Number of elements in argv.
+ *             argv  : Array of NULL terminated strings.
+ *			 inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *			 outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : print argv[1] with any leading directories and trailing slashes 
+ *					removed, and with argv[2] removed from its end if it is a suffix
+ *					of what remains.
+ *
+ * NOTES          : argv[1] is not modified.
+ ********************************************************************************/
+void builtin_basename(int argc, char **argv, int inputFD, int outputFD) {
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "usage: basename string [suffix]\n");
+		builtinStatus = 1;
+		return;
+	}
+	const char *path = argv[1];
+	size_t end = strlen(path);
+	while (end > 1 && path[end-1] == '/')
+		end--;
+	size_t start = end;
+	while (start > 0 && path[start-1] != '/')
+		start--;
+	/* "/" and "//" are their own basename */
+	if (start == end && end > 0)
+		start = end-1;
+	if (argc == 3) {
+		size_t suffixLength = strlen(argv[2]);
+		if (suffixLength < end-start && strncmp(path+end-suffixLength, argv[2], suffixLength) == 0)
+			end -= suffixLength;
+	}
+	write(outputFD, path+start, end-start);
+	write(outputFD, "\n", 1);
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+########################################################################################
+# File name	: builtins.sh
+#
+# Created by	: James Johns
+# Date created	: 19/10/2026
+#
+# Description	: Loadable builtin benchmark. Runs COUNT (default 5000) basename commands
+#					in one MyShell script, first with /usr/bin/basename and then with
+#					basename.so loaded by enable -f, and prints the time and commands per
+#					second of each run.
+#
+#					usage: bench/builtins.sh			(run from MyShell/, after make)
+#
+# NOTES		:	the difference between the two runs is the cost of the fork and exec
+#					the loaded builtin avoids.
+########################################################################################
+
+SHELL_BINARY=${SHELL_BINARY:-./shell}
+COUNT=${COUNT:-5000}
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT" "$SCRIPT.loaded"' EXIT
+
+for ((i = 0; i < COUNT; i++)); do
+	echo "basename /usr/share/doc/file$i.txt .txt"
+done > "$SCRIPT"
+{ echo "enable -f ./basename.so basename"; cat "$SCRIPT"; } > "$SCRIPT.loaded"
+
+printf "%-10s %12s %12s\n" "basename" "seconds" "commands/s"
+for run in external loaded; do
+	script=$SCRIPT
+	[ $run = loaded ] && script=$SCRIPT.loaded
+	start=$(date +%s%N)
+	lines=$("$SHELL_BINARY" "$script" 2>/dev/null | grep -c "^file[0-9]*$")
+	end=$(date +%s%N)
+	if [ "$lines" -ne "$COUNT" ]; then
+		echo "$run: expected $COUNT lines of output, got $lines" >&2
+		exit 1
+	fi
+	awk -v run=$run -v ns=$((end-start)) -v count=$COUNT \
+		'BEGIN { printf "%-10s %12.3f %12.0f\n", run, ns/1e9, count/(ns/1e9) }'
+done
@@ -0,0 +1,38 @@
+#!/bin/bash
+########################################################################################
+# File name	: pipesize.sh
+#
+# Created by	: James Johns
+# Date created	: 19/10/2026
+#
+# Description	: Pipe throughput benchmark. Moves BYTES (default 10G) of zeroes through
+#					cat | cat | cat in MyShell once for each pipe size given, and prints
+#					the time and throughput of each run.
+#
+#					usage: bench/pipesize.sh [size ...]		(run from MyShell/, after make)
+#
+#					sizes are as accepted by set pipesize=, default 64K 256K 1M. 0 runs
+#					with the system default.
+#
+# NOTES		:	BYTES=1G bench/pipesize.sh gives a quicker, rougher run.
+########################################################################################
+
+SHELL_BINARY=${SHELL_BINARY:-./shell}
+BYTES=${BYTES:-10G}
+SIZES=("$@")
+[ ${#SIZES[@]} -eq 0 ] && SIZES=(64K 256K 1M)
+
+printf "%-10s %12s %12s\n" "pipesize" "seconds" "MB/s"
+for size in "${SIZES[@]}"; do
+	start=$(date +%s%N)
+	moved=$("$SHELL_BINARY" -c "set pipesize=$size
+head -c $BYTES /dev/zero | cat | cat | cat | wc -c" 2>/dev/null | tail -n 1)
+	end=$(date +%s%N)
+	nanoseconds=$((end-start))
+	if [ -z "$moved" ] || [ "$moved" -eq 0 ]; then
+		echo "pipesize=$size: pipeline moved no data" >&2
+		exit 1
+	fi
+	awk -v size="$size" -v ns="$nanoseconds" -v bytes="$moved" \
+		'BEGIN { printf "%-10s %12.3f %12.1f\n", size, ns/1e9, bytes/1048576/(ns/1e9) }'
+done
@@ -0,0 +1,48 @@
+#!/bin/bash
+########################################################################################
+# File name	: server.sh
+#
+# Created by	: James Johns
+# Date created	: 19/10/2026
+#
+# Description	: Server mode throughput benchmark. Starts MyShell --server, then sends
+#					REQUESTS (default 2000) tiny scripts from CONCURRENCY (default 16)
+#					shellclient processes at once, and prints requests per second. The
+#					same load is then run as one MyShell -c process per request, for
+#					comparison.
+#
+#					usage: bench/server.sh			(run from MyShell/, after make)
+#
+# NOTES		:	Each request runs pwd, a builtin, so the numbers measure request
+#					handling rather than the command run.
+########################################################################################
+
+SHELL_BINARY=${SHELL_BINARY:-./shell}
+CLIENT_BINARY=${CLIENT_BINARY:-./shellclient}
+REQUESTS=${REQUESTS:-2000}
+CONCURRENCY=${CONCURRENCY:-16}
+SOCKET=$(mktemp -u /tmp/myshell-bench.XXXXXX)
+
+"$SHELL_BINARY" --server "$SOCKET" &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; rm -f "$SOCKET"' EXIT
+for i in $(seq 50); do
+	[ -S "$SOCKET" ] && break
+	sleep 0.1
+done
+
+# run_load <command ...> - run the command REQUESTS times, CONCURRENCY at once, and
+# print requests per second. fails if any request fails.
+run_load() {
+	local start end
+	start=$(date +%s%N)
+	seq "$REQUESTS" | xargs -P "$CONCURRENCY" -I{} "$@" >/dev/null || return 1
+	end=$(date +%s%N)
+	awk -v n="$REQUESTS" -v ns="$((end-start))" 'BEGIN { printf "%10.0f requests/s  (%.3f s)\n", n/(ns/1e9), ns/1e9 }'
+}
+
+echo "$REQUESTS requests, $CONCURRENCY concurrent"
+printf "%-24s" "server + shellclient:"
+run_load "$CLIENT_BINARY" "$SOCKET" pwd || { echo "server requests failed" >&2; exit 1; }
+printf "%-24s" "MyShell -c per request:"
+run_load "$SHELL_BINARY" -c pwd || { echo "MyShell -c failed" >&2; exit 1; }
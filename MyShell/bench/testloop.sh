@@ -0,0 +1,49 @@
+#!/bin/bash
+########################################################################################
+# File name	: testloop.sh
+#
+# Created by	: James Johns
+# Date created	: 19/10/2026
+#
+# Description	: Test builtin benchmark. Runs a COUNT (default 5000) step counter loop as
+#					a MyShell script, each step incrementing i with $(( )) and comparing
+#					it with [. The loop runs once with the [ builtin and once with
+#					/usr/bin/test, and the time and steps per second of each are printed.
+#
+#					usage: bench/testloop.sh			(run from MyShell/, after make)
+#
+# NOTES		:	the script has no loop construct, so the loop is unrolled into COUNT
+#					lines. both runs evaluate $(( )) in the shell, so the difference is
+#					the fork and exec of /usr/bin/test.
+########################################################################################
+
+SHELL_BINARY=${SHELL_BINARY:-./shell}
+COUNT=${COUNT:-5000}
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT"' EXIT
+
+printf "%-10s %12s %12s\n" "test" "seconds" "steps/s"
+for run in builtin external; do
+	command="["
+	closing=" ]"
+	if [ $run = external ]; then
+		command=$(type -P test)
+		closing=""
+	fi
+	for ((i = 0; i < COUNT; i++)); do
+		echo "$command \$((i=i+1)) -le $COUNT$closing"
+	done > "$SCRIPT"
+	# the last line is counted out past the end of the loop, so the script fails only
+	# if the counter went wrong
+	echo "$command \$((i=i+1)) -le $COUNT$closing" >> "$SCRIPT"
+	start=$(date +%s%N)
+	"$SHELL_BINARY" "$SCRIPT" >/dev/null 2>&1
+	status=$?
+	end=$(date +%s%N)
+	if [ $status -ne 1 ]; then
+		echo "$run: expected the step past the loop to fail, got status $status" >&2
+		exit 1
+	fi
+	awk -v run=$run -v ns=$((end-start)) -v count=$COUNT \
+		'BEGIN { printf "%-10s %12.3f %12.0f\n", run, ns/1e9, count/(ns/1e9) }'
+done
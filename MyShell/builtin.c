@@ -12,9 +12,13 @@
  *							defaulting to /home/
  ****************************************************************************************/
 
+#define _GNU_SOURCE /* strdup() and fileno() */
+
 #include "builtin.h"
 #include "ps.h"
 #include "kill.h"
+#include "trace.h"
+#include "test.h"
 
 #include <ctype.h>
 #include <limits.h>
@@ -25,6 +29,36 @@
 #include <signal.h>
 #include <string.h>
 #include <dirent.h>
+#include <stdint.h>
+#include <sys/wait.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+
+long shellPipeSize = 0;
+int shellArgBatch = 0;
+int builtinStatus = 0;
+
+/* builtins compiled into the shell, copied into builtinTable on first use */
+static const struct builtin_s staticBuiltins[] = {
+	{ "cd", builtin_cd, 0 },
+	{ "quit", NULL, BUILTIN_EXIT },
+	{ "exit", NULL, BUILTIN_EXIT },
+	{ "pwd", builtin_pwd, 0 },
+	{ "kill", builtin_kill, 0 },
+	{ "ps", builtin_ps, 0 },
+	{ "set", builtin_set, 0 },
+	{ "exec", NULL, BUILTIN_EXEC },
+	{ "enable", builtin_enable, 0 },
+	{ "test", builtin_test, 0 },
+	{ "[", builtin_test, 0 },
+	{ "[[", builtin_test, 0 },
+	{ NULL, NULL, 0 }
+};
+
+/* open addressed hash table of every builtin, keyed by name. builtinTableSize is a
+ * power of two and is kept at least twice builtinCount, so probes stay short */
+static struct builtin_s *builtinTable = NULL;
+static size_t builtinTableSize = 0, builtinCount = 0;
 
 /********************************************************************************
  * Function name  : void builtin_pwd(int argc, char **argv)
@@ -82,11 +116,343 @@ void builtin_cd(int argc, char **argv, int inputFD, int outputFD) {
 	}
 	else {
 		fprintf(stderr, "Invalid arguments");
+		builtinStatus = 1;
 		return;
 	}
 	
-	if (chdir(directory) != 0) 
+	if (chdir(directory) != 0) {
 		perror("cd");
+		builtinStatus = 1;
+	}
+}
+
+/********************************************************************************
+ * Function name  : void builtin_set(int argc, char **argv, int inputFD, int outputFD)
+ *             argc  : Number of elements in argv.
+ *             argv  : Array of NULL terminated strings.
+ *			 inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *			 outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : Change shell settings given as name=value arguments. With no
+ *                  arguments, print the current value of every setting.
+ *
+ *					pipesize=<bytes>[K|M|G] - capacity requested for pipes created
+ *												between pipeline stages. 0 restores the
+ *												system default.
+ *					argbatch=on|off			- when expanded arguments exceed ARG_MAX, run
+ *												the command repeatedly on batches of them,
+ *												as xargs would, instead of refusing it.
+ *					trace=<file>|off		- append a record of every command run to the
+ *												ring buffer in file. see trace.h
+ *
+ * NOTES          : 
+ ********************************************************************************/
+void builtin_set(int argc, char **argv, int inputFD, int outputFD) {
+	char buffer[64];
+	if (argc == 1) {
+		int length = snprintf(buffer, sizeof(buffer), "pipesize=%ld\nargbatch=%s\ntrace=", shellPipeSize,
+							  shellArgBatch ? "on" : "off");
+		write(outputFD, buffer, length);
+		const char *trace = tracePath() != NULL ? tracePath() : "off";
+		write(outputFD, trace, strlen(trace));
+		write(outputFD, "\n", 1);
+		return;
+	}
+	for (int i = 1; i < argc; i++) {
+		char *value = strchr(argv[i], '=');
+		if (value == NULL) {
+			fprintf(stderr, "set: expected name=value, got %s\n", argv[i]);
+			builtinStatus = 1;
+			continue;
+		}
+		value++;
+		if (strncmp(argv[i], "pipesize=", 9) == 0) {
+			char *end;
+			long size = strtol(value, &end, 10);
+			switch (toupper(*end)) {
+				case 'G':
+					size *= 1024;
+				case 'M':
+					size *= 1024;
+				case 'K':
+					size *= 1024;
+					end++;
+					break;
+			}
+			if (end == value || *end != '\0' || size < 0 || size > INT_MAX) {
+				fprintf(stderr, "set: invalid pipe size %s\n", value);
+				builtinStatus = 1;
+			}
+			else {
+				shellPipeSize = size;
+			}
+		}
+		else if (strncmp(argv[i], "argbatch=", 9) == 0) {
+			if (strcmp(value, "on") == 0 || strcmp(value, "1") == 0)
+				shellArgBatch = 1;
+			else if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0)
+				shellArgBatch = 0;
+			else {
+				fprintf(stderr, "set: argbatch must be on or off\n");
+				builtinStatus = 1;
+			}
+		}
+		else if (strncmp(argv[i], "trace=", 6) == 0) {
+			if (strcmp(value, "off") == 0)
+				traceClose();
+			else if (traceOpen(value) != 0)
+				builtinStatus = 1;
+		}
+		else {
+			fprintf(stderr, "set: unknown setting %s\n", argv[i]);
+			builtinStatus = 1;
+		}
+	}
+}
+
+/********************************************************************************
+ * Function name  : static size_t hashBuiltinName(const char *name)
+ *			returns	: FNV-1a hash of name.
+ *				name	: NULL terminated command name.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : hash function for builtinTable.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static size_t hashBuiltinName(const char *name) {
+	uint32_t hash = 2166136261u;
+	for (; *name != '\0'; name++) {
+		hash ^= (unsigned char)*name;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/********************************************************************************
+ * Function name  : static struct builtin_s *findSlot(struct builtin_s *table, size_t size,
+ *														const char *name)
+ *			returns	: the slot holding name, or the empty slot where it belongs.
+ *				table	: hash table of size slots, with at least one empty.
+ *				size	: number of slots in table. a power of two.
+ *				name	: command name to look for.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : linear probe from name's hash until name or an empty slot is found.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static struct builtin_s *findSlot(struct builtin_s *table, size_t size, const char *name) {
+	size_t mask = size-1;
+	for (size_t i = hashBuiltinName(name) & mask; ; i = (i+1) & mask) {
+		if (table[i].name == NULL || strcmp(table[i].name, name) == 0)
+			return &table[i];
+	}
+}
+
+/********************************************************************************
+ * Function name  : int registerBuiltin(const char *name, builtin_f function, int flags)
+ *			returns	: 0 on success, -1 on allocation failure.
+ *				name	 : command name to run function for. not copied.
+ *				function : function to call with the command's arguments.
+ *				flags	 : BUILTIN_* flags.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : add a builtin, replacing any existing builtin of the same name.
+ *					the table is doubled and rehashed when it becomes half full.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+int registerBuiltin(const char *name, builtin_f function, int flags) {
+	if ((builtinCount+1)*2 > builtinTableSize) {
+		size_t newSize = builtinTableSize ? builtinTableSize*2 : 32;
+		struct builtin_s *newTable = calloc(newSize, sizeof(struct builtin_s));
+		if (newTable == NULL) {
+			perror("registerBuiltin");
+			return -1;
+		}
+		for (size_t i = 0; i < builtinTableSize; i++) {
+			if (builtinTable[i].name != NULL)
+				*findSlot(newTable, newSize, builtinTable[i].name) = builtinTable[i];
+		}
+		free(builtinTable);
+		builtinTable = newTable;
+		builtinTableSize = newSize;
+	}
+	struct builtin_s *slot = findSlot(builtinTable, builtinTableSize, name);
+	if (slot->name == NULL)
+		builtinCount++;
+	slot->name = name;
+	slot->function = function;
+	slot->flags = flags;
+	return 0;
+}
+
+/********************************************************************************
+ * Function name  : const struct builtin_s *findBuiltin(const char *name)
+ *			returns	: the builtin called name, or NULL if name is not a builtin.
+ *				name	: command name, as found in argv[0].
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : look name up in the builtin table, filling the table from 
+ *					staticBuiltins on first use.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+const struct builtin_s *findBuiltin(const char *name) {
+	if (builtinTable == NULL) {
+		for (int i = 0; staticBuiltins[i].name != NULL; i++)
+			registerBuiltin(staticBuiltins[i].name, staticBuiltins[i].function, staticBuiltins[i].flags);
+		if (builtinTable == NULL)
+			return NULL;
+	}
+	struct builtin_s *slot = findSlot(builtinTable, builtinTableSize, name);
+	return slot->name != NULL ? slot : NULL;
+}
+
+/********************************************************************************
+ * Function name  : int isBuiltin(const char *name)
+ *			returns	: 1 if name is run by the shell itself, otherwise 0.
+ *				name	: command name, as found in argv[0].
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : test whether launchCommand() would run name without fork()ing.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+int isBuiltin(const char *name) {
+	return findBuiltin(name) != NULL;
+}
+
+/********************************************************************************
+ * Function name  : void builtin_enable(int argc, char **argv, int inputFD, int outputFD)
+ *             argc  : Number of elements in argv.
+ *             argv  : Array of NULL terminated strings.
+ *			 inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *			 outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : load builtins from a shared object, or list the builtins available.
+ *
+ *					No arguments specified	- print the name of every builtin
+ *					-f <file> <name> ...	- dlopen() file and register each name as a 
+ *												builtin, calling the function file 
+ *												exports as builtin_<name>
+ *
+ * NOTES          : loaded functions take the same (argc, argv, inputFD, outputFD) 
+ *					arguments as the builtins in this file, and report failure by setting
+ *					builtinStatus. shared objects are never unloaded once one of their
+ *					functions is registered. builtins compiled into the shell cannot be
+ *					replaced.
+ ********************************************************************************/
+void builtin_enable(int argc, char **argv, int inputFD, int outputFD) {
+	if (argc == 1) {
+		findBuiltin("");
+		for (size_t i = 0; i < builtinTableSize; i++) {
+			if (builtinTable[i].name == NULL)
+				continue;
+			write(outputFD, builtinTable[i].name, strlen(builtinTable[i].name));
+			if (builtinTable[i].flags & BUILTIN_LOADED)
+				write(outputFD, " (loaded)", 9);
+			write(outputFD, "\n", 1);
+		}
+		return;
+	}
+	if (argc < 4 || strcmp(argv[1], "-f") != 0) {
+		fprintf(stderr, "usage: enable [-f file name ...]\n");
+		builtinStatus = 1;
+		return;
+	}
+	
+	void *library = dlopen(argv[2], RTLD_NOW | RTLD_LOCAL);
+	if (library == NULL) {
+		fprintf(stderr, "enable: %s\n", dlerror());
+		builtinStatus = 1;
+		return;
+	}
+	int registered = 0;
+	for (int i = 3; i < argc; i++) {
+		/* only loaded builtins may be replaced. the shell relies on its own */
+		const struct builtin_s *existing = findBuiltin(argv[i]);
+		if (existing != NULL && !(existing->flags & BUILTIN_LOADED)) {
+			fprintf(stderr, "enable: %s is a shell builtin and cannot be replaced\n", argv[i]);
+			builtinStatus = 1;
+			continue;
+		}
+		char symbol[256];
+		snprintf(symbol, sizeof(symbol), "builtin_%s", argv[i]);
+		builtin_f function = (builtin_f)dlsym(library, symbol);
+		char *name = strdup(argv[i]);
+		if (function == NULL) {
+			fprintf(stderr, "enable: %s does not export %s\n", argv[2], symbol);
+			builtinStatus = 1;
+			free(name);
+		}
+		else if (name == NULL || registerBuiltin(name, function, BUILTIN_LOADED) != 0) {
+			perror("enable");
+			builtinStatus = 1;
+			free(name);
+		}
+		else {
+			registered++;
+		}
+	}
+	/* nothing refers to a library none of whose functions were registered */
+	if (registered == 0)
+		dlclose(library);
+}
+
+/********************************************************************************
+ * Function name  : int execInPlace(int argc, char **argv, int inputFD, int outputFD)
+ *			returns	: only returns if the command could not be executed, with a positive value.
+ *				argc	: Number of elements in argv.
+ *				argv	: Array of NULL terminated strings.
+ *				inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *				outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : replace the shell process with argv, with inputFD and outputFD as its
+ *					stdin and stdout. used by the exec builtin and for the final command of
+ *					a script or -c string, where the fork and wait would be wasted.
+ *
+ * NOTES          : buffered output is flushed first, since exec discards it. on failure
+ *					the shell's stdin and stdout are restored, and inputFD and outputFD
+ *					are closed.
+ ********************************************************************************/
+int execInPlace(int argc, char **argv, int inputFD, int outputFD) {
+	int savedInput = -1, savedOutput = -1;
+	fflush(NULL);
+	if (inputFD != STDIN_FILENO) {
+		savedInput = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 3);
+		dup2(inputFD, STDIN_FILENO);
+		close(inputFD);
+	}
+	if (outputFD != STDOUT_FILENO) {
+		savedOutput = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+		dup2(outputFD, STDOUT_FILENO);
+		close(outputFD);
+	}
+	execvp(argv[0], argv);
+	perror(argv[0]);
+	/* the shell carries on, so give it back its own stdin and stdout */
+	if (savedInput >= 0) {
+		dup2(savedInput, STDIN_FILENO);
+		close(savedInput);
+	}
+	if (savedOutput >= 0) {
+		dup2(savedOutput, STDOUT_FILENO);
+		close(savedOutput);
+	}
+	return 1;
 }
 
 /********************************************************************************
@@ -104,29 +470,64 @@ void builtin_cd(int argc, char **argv, int inputFD, int outputFD) {
  *						environment path. 
  *	                    otherwise it executes the command as a part of the current process. e.g. CD
  *
- * NOTES          : 
+ * NOTES          : waits for the new process to end. use launchCommand() to start a 
+ *					pipeline stage without waiting.
  ********************************************************************************/
 int forkAndExecute(int argc, char **argv, int inputFD, int outputFD) {
-	/* cd and exit/quit are not supported by multi-processing. deal with them without fork()ing */
-	if (strcmp(argv[0], "cd") == 0) {
-		builtin_cd(argc, argv, inputFD, outputFD);
+	pid_t pid = 0;
+	int commandReturn = launchCommand(argc, argv, inputFD, outputFD, &pid);
+	if (pid > 0) {
+		/* wait for process to end */
+		waitpid(pid, NULL, 0);
 	}
-	else if ((strcmp(argv[0], "quit") == 0) || (strcmp(argv[0], "exit") == 0)) {
+	if (inputFD != fileno(stdin))
+	  close(inputFD);
+	if (outputFD != fileno(stdout))
+	  close(outputFD);
+
+	return commandReturn;
+}
+
+/********************************************************************************
+ * Function name  : int launchCommand(int argc, char **argv, int inputFD, int outputFD, 
+ *										pid_t *childPID)
+ *			returns	: 0 on success, positive on failure, negative on termination.
+ *				argc	: Number of elements in argv.
+ *				argv	: Array of NULL terminated strings.
+ *				inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *				outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *				childPID: set to the pid of the new process, or 0 if no process was created.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : runs builtins as a part of the current process, otherwise fork()s a new
+ *					process to execute argv and returns without waiting for it.
+ *
+ * NOTES          : inputFD and outputFD are left open. the caller closes its copies once
+ *					the stage is launched, so that readers further down a pipeline see EOF.
+ ********************************************************************************/
+int launchCommand(int argc, char **argv, int inputFD, int outputFD, pid_t *childPID) {
+	*childPID = 0;
+	/* cd and exit/quit are not supported by multi-processing. deal with them without fork()ing */
+	const struct builtin_s *builtin = findBuiltin(argv[0]);
+	if (builtin != NULL && (builtin->flags & BUILTIN_EXIT)) {
 		return -1;
 	}
-	else if (strcmp(argv[0], "pwd") == 0) {
-		builtin_pwd(argc, argv, inputFD, outputFD);
+	else if (builtin != NULL && (builtin->flags & BUILTIN_EXEC)) {
+		/* exec only replaces the shell for a command on its own, which executeCommand() 
+		 * handles. as one stage of a pipeline it runs like any other command */
+		if (argc > 1)
+			return launchCommand(argc-1, argv+1, inputFD, outputFD, childPID);
 	}
-	else if (strcmp(argv[0], "kill") == 0) {
-		builtin_kill(argc, argv, inputFD, outputFD);
-	}
-	else if (strcmp(argv[0], "ps") == 0) {
-		builtin_ps(argc, argv, inputFD, outputFD);
+	else if (builtin != NULL) {
+		builtinStatus = 0;
+		builtin->function(argc, argv, inputFD, outputFD);
 	}
 	else {
 		int pid = fork();
 		if (pid == 0) {
-			/* child. setup pipes for redirecting input/output */
+			/* child. setup pipes for redirecting input/output. dup2() clears close-on-exec 
+			 * on the new descriptors, every other pipeline fd is closed by execvp() */
 			inputFD = dup2(inputFD, 0);
 			outputFD = dup2(outputFD, 1);
 			/* execute command */
@@ -135,17 +536,12 @@ int forkAndExecute(int argc, char **argv, int inputFD, int outputFD) {
 			exit(1);
 		}
 		else if (pid > 0) {
-			/* wait for process to end */
-			waitpid(pid, NULL, 0);
+			*childPID = pid;
 		}
 		else {
-			perror("forkAndExecute");
+			perror("launchCommand");
+			return 1;
 		}
 	}
-	if (inputFD != fileno(stdin))
-	  close(inputFD);
-	if (outputFD != fileno(stdout))
-	  close(outputFD);
-
 	return 0;
 }
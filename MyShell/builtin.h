@@ -11,7 +11,7 @@
  ****************************************************************************************/
 
 #ifndef _BUILTIN_H_
-#define _BIULTIN_H_
+#define _BUILTIN_H_
 
 #define MAXPATHLENGTH 1024
 
@@ -20,9 +20,40 @@
 #define PATH_MAX 4096
 #endif
 
+#include <sys/types.h>
+
+/* shell settings, changed at run time with the set builtin */
+extern long shellPipeSize; /* capacity requested for pipeline pipes, 0 for the system default */
+extern int shellArgBatch; /* if 1, split commands whose arguments exceed ARG_MAX into batches */
+
+/* exit status of the builtin launchCommand() last ran. reset to 0 before each builtin, 
+ * which may set it to report failure */
+extern int builtinStatus;
+
+/* every builtin, compiled in or loaded with enable -f, has this signature */
+typedef void (*builtin_f)(int argc, char **argv, int inputFD, int outputFD);
+
+struct builtin_s {
+	const char *name;
+	builtin_f function;	/* NULL for the builtins launchCommand() handles itself */
+	int flags;			/* BUILTIN_* */
+};
+
+#define BUILTIN_EXIT 1		/* ends the shell */
+#define BUILTIN_EXEC 2		/* runs its arguments as a command */
+#define BUILTIN_LOADED 4	/* loaded from a shared object by enable -f */
+
+const struct builtin_s *findBuiltin(const char *name);
+int registerBuiltin(const char *name, builtin_f function, int flags);
+
 void builtin_pwd(int argc, char **argv, int inputFD, int outputFD);
 void builtin_cd(int argc, char **argv, int inputFD, int outputFD);
+void builtin_set(int argc, char **argv, int inputFD, int outputFD);
+void builtin_enable(int argc, char **argv, int inputFD, int outputFD);
 
+int isBuiltin(const char *name);
+int execInPlace(int argc, char **argv, int inputFD, int outputFD);
 int forkAndExecute(int argc, char **argv, int inputFD, int outputFD);
+int launchCommand(int argc, char **argv, int inputFD, int outputFD, pid_t *childPID);
 
 #endif
@@ -0,0 +1,161 @@
+/****************************************************************************************
+ * File name	: client.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Client for MyShell server mode. Sends a script to a server started with
+ *					MyShell --server <socket>, copies its output to stdout and stderr and
+ *					exits with the script's exit status.
+ *
+ *					usage: shellclient <socket> [command [arguments ...]]
+ *
+ *					with a command, runs that single command line. otherwise the script
+ *					is read from stdin.
+ *
+ * NOTES		:	built on its own, without readline or the rest of the shell, so that
+ *					starting it costs as little as possible.
+ ****************************************************************************************/
+
+#include "server.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+/********************************************************************************
+ * Function name  : static int writeFully(int fd, const char *buffer, size_t length)
+ *     returns    : zero on success, -1 on error
+ *         fd        : file descriptor to write to
+ *         buffer    : data to write
+ *         length    : number of bytes of buffer to write
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : write the whole of buffer, retrying short writes.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int writeFully(int fd, const char *buffer, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, buffer, length);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buffer += written;
+		length -= written;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int readFully(int fd, char *buffer, size_t length)
+ *     returns    : zero on success, -1 on error or if the connection closed early
+ *         fd        : file descriptor to read from
+ *         buffer    : receives length bytes
+ *         length    : number of bytes to read
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : read exactly length bytes, retrying short reads.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int readFully(int fd, char *buffer, size_t length) {
+	while (length > 0) {
+		ssize_t received = read(fd, buffer, length);
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			return -1;
+		buffer += received;
+		length -= received;
+	}
+	return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <socket> [command [arguments ...]]\n", argv[0]);
+		return 2;
+	}
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(argv[1]) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "%s: socket path too long\n", argv[0]);
+		return 2;
+	}
+	strcpy(address.sun_path, argv[1]);
+	int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connection < 0 || connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0) {
+		perror("connect");
+		return 2;
+	}
+
+	/* send the request, then shut down our side to mark its end */
+	char *buffer = malloc(SERVER_FRAME_MAX_PAYLOAD);
+	if (buffer == NULL) {
+		perror("malloc");
+		return 2;
+	}
+	if (argc > 2) {
+		for (int i = 2; i < argc; i++) {
+			if (writeFully(connection, argv[i], strlen(argv[i])) != 0 ||
+				writeFully(connection, i+1 < argc ? " " : "\n", 1) != 0) {
+				perror("write");
+				return 2;
+			}
+		}
+	}
+	else {
+		ssize_t length;
+		while ((length = read(STDIN_FILENO, buffer, SERVER_FRAME_MAX_PAYLOAD)) != 0) {
+			if (length < 0 && errno == EINTR)
+				continue;
+			if (length < 0 || writeFully(connection, buffer, length) != 0) {
+				perror("write");
+				return 2;
+			}
+		}
+	}
+	shutdown(connection, SHUT_WR);
+
+	/* demultiplex frames until the exit status arrives */
+	for (;;) {
+		uint32_t header[2];
+		if (readFully(connection, (char *)header, SERVER_FRAME_HEADER_SIZE) != 0) {
+			fprintf(stderr, "%s: connection closed before exit status\n", argv[0]);
+			return 2;
+		}
+		uint32_t type = ntohl(header[0]), length = ntohl(header[1]);
+		if (length > SERVER_FRAME_MAX_PAYLOAD || readFully(connection, buffer, length) != 0) {
+			fprintf(stderr, "%s: malformed reply\n", argv[0]);
+			return 2;
+		}
+		if (type == SERVER_FRAME_STDOUT) {
+			writeFully(STDOUT_FILENO, buffer, length);
+		}
+		else if (type == SERVER_FRAME_STDERR) {
+			writeFully(STDERR_FILENO, buffer, length);
+		}
+		else if (type == SERVER_FRAME_EXIT && length == sizeof(uint32_t)) {
+			uint32_t status;
+			memcpy(&status, buffer, sizeof(status));
+			close(connection);
+			free(buffer);
+			return (int)ntohl(status);
+		}
+	}
+}
@@ -12,15 +12,26 @@
  *							data instead of limited lengths.
  ****************************************************************************************/
 
+#define _GNU_SOURCE /* pipe2() and F_SETPIPE_SZ */
+
 #include "commands.h"
 #include "builtin.h"
+#include "expand.h"
+#include "arith.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 
+int lastExitStatus = 0;
+
 
 /********************************************************************************
  * Function name  : int interpretCommand(char **buffer)
@@ -44,6 +55,37 @@ int readCommandLine(char **buffer) {
 }
 
 
+/********************************************************************************
+ * Function name  : static int createPipe(int pipeFDs[2])
+ *     returns    : zero on success, -1 on failure with errno set
+ *         pipeFDs   : receives the read end and write end of the new pipe
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : create a close-on-exec pipe for joining two pipeline stages,
+ *                  sized to shellPipeSize if the set builtin has changed it.
+ *
+ * NOTES          : close-on-exec stops every child from inheriting the pipe ends
+ *                  of the other stages, which would hold readers off EOF.
+ ********************************************************************************/
+static int createPipe(int pipeFDs[2]) {
+#ifdef __linux__
+	if (pipe2(pipeFDs, O_CLOEXEC) == -1)
+		return -1;
+#else
+	if (pipe(pipeFDs) == -1)
+		return -1;
+	fcntl(pipeFDs[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipeFDs[1], F_SETFD, FD_CLOEXEC);
+#endif
+#ifdef F_SETPIPE_SZ
+	if (shellPipeSize > 0 && fcntl(pipeFDs[1], F_SETPIPE_SZ, (int)shellPipeSize) == -1)
+		perror("createPipe: F_SETPIPE_SZ");
+#endif
+	return 0;
+}
+
+
 /********************************************************************************
  * Function name  : struct command_s *interpretCommand(char *commandLine)
  *     returns    : pointer to a command_s structure containing all command
@@ -77,7 +119,7 @@ struct command_s *interpretCommand(char *commandLine) {
 		toRet->next = NULL;
 		toRet->backgroundTask = 0;
 		toRet->inputFD = toRet->outputFD = -1;
-		toRet->argc = 0;
+		toRet->argc = toRet->fixedArgc = toRet->trailingArgc = 0;
 		toRet->argv = malloc(sizeof(char *)*2);
 		if (toRet->argv == NULL) {
 			perror("interpretCommand: malloc");
@@ -112,6 +154,8 @@ struct command_s *interpretCommand(char *commandLine) {
 		
 		i++;
 		startOfToken = i;
+		/* && and || are operators of [[ until its closing ]], not pipes or background tasks */
+		int inDoubleBracket = strcmp(toRet->argv[0], "[[") == 0;
 		
 		/* loop until we reach the end of the string or we hit a new line character
 		 * tokenising the string at each space character */
@@ -131,20 +175,42 @@ struct command_s *interpretCommand(char *commandLine) {
 					tempStore[toRet->argc] = malloc(sizeof(char)*(i-startOfToken)+1);
 					strncpy(tempStore[toRet->argc],commandLine+startOfToken,i-startOfToken);
 					tempStore[toRet->argc][i-startOfToken] = '\0';
+					if (strcmp(tempStore[toRet->argc], "]]") == 0)
+						inDoubleBracket = 0;
 					toRet->argc++;
 					/* set records to beginning of the next possible token */
 					startOfToken = i;
 					break;
 				case '|':
+					if (inDoubleBracket && commandLine[i+1] == '|') {
+						i += 2;
+						break;
+					}
 					toRet->next = interpretCommand(commandLine+i+1);
-					i = strlen(commandLine);
+					/* the rest of the line belongs to the next stage, so no token is left to close */
+					i = startOfToken = strlen(commandLine);
 					break;
+				case '$': {
+					/* keep $(( ... )) in one argument, whatever it contains */
+					size_t length = arithmeticLength(commandLine+i);
+					i += length > 0 ? length : 1;
+					break;
+				}
 				case '&':
+					if (inDoubleBracket && commandLine[i+1] == '&') {
+						i += 2;
+						break;
+					}
 					/* send child process to background */
 					toRet->backgroundTask = 1;
 					i++;
 					break;
   			        case '>':
+					/* inside [[ ]], > compares strings */
+					if (inDoubleBracket) {
+						i++;
+						break;
+					}
 				        /* next argument is the file to redirect into. */;
 				        i++;
 				        while (commandLine[i] == ' ' || commandLine[i] == '\t')
@@ -182,11 +248,19 @@ struct command_s *interpretCommand(char *commandLine) {
 			toRet->argv[toRet->argc] = NULL;
 		}
 		
+		/* replace $(( expression )) with its value, then *, ? and [...] patterns with 
+		 * the paths they match. [[ takes its patterns as they are written */
+		if (expandArithmetic(toRet) != 0 ||
+			(strcmp(toRet->argv[0], "[[") != 0 && expandGlobs(toRet) != 0)) {
+			destroyCommand(toRet);
+			return NULL;
+		}
+		
 		/* check I/O file descriptors and assign pipes as necessary */
 		if (toRet->outputFD == -1 && toRet->next != NULL) {
 			/* create a pipe, assign to outputFD and next->outputFD */
 			int newpipe[2];
-			if (pipe(newpipe) == -1) {
+			if (createPipe(newpipe) == -1) {
 				perror("interpretCommand: pipe");
 				destroyCommand(toRet);
 				return NULL;
@@ -207,6 +281,150 @@ struct command_s *interpretCommand(char *commandLine) {
 }
 
 
+/********************************************************************************
+ * Function name  : static int launchInBatches(struct command_s *command, pid_t *childPID)
+ *     returns    : 0 on success, positive on failure
+ *         command   : pipeline stage whose arguments do not fit in one execvp() call
+ *         childPID  : set to the pid of the process running the batches
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : fork a process that runs command once per batch of arguments, 
+ *                  one batch after another, in the manner of xargs. the first
+ *                  command->fixedArgc arguments are repeated at the front of every 
+ *                  batch, and the last command->trailingArgc at the end, so that
+ *                  cp *.c dir copies every batch into dir.
+ *
+ * NOTES          : running the batches from a single child keeps their output in 
+ *                  order and lets the rest of the pipeline treat them as one stage.
+ ********************************************************************************/
+static int launchInBatches(struct command_s *command, pid_t *childPID) {
+	/* anything still buffered would otherwise be written by both processes */
+	fflush(NULL);
+	*childPID = fork();
+	if (*childPID < 0) {
+		perror("launchInBatches");
+		return 1;
+	}
+	else if (*childPID > 0) {
+		return 0;
+	}
+	
+	/* child. build each batch in place and wait for it before starting the next */
+	long limit = execArgumentLimit();
+	int status = 0;
+	unsigned int fixed = command->fixedArgc, next = fixed;
+	unsigned int trailing = command->trailingArgc, end = command->argc-trailing;
+	char **batch = malloc(sizeof(char *)*(command->argc+1));
+	if (batch == NULL) {
+		perror("launchInBatches");
+		exit(1);
+	}
+	long fixedSize = sizeof(char *);
+	for (unsigned int i = 0; i < fixed; i++) {
+		batch[i] = command->argv[i];
+		fixedSize += argumentSize(command->argv[i]);
+	}
+	for (unsigned int i = end; i < command->argc; i++)
+		fixedSize += argumentSize(command->argv[i]);
+	while (next < end) {
+		unsigned int batchArgc = fixed;
+		long size = fixedSize;
+		/* always take at least one argument so an oversized one is still attempted */
+		while (next < end && 
+			   (batchArgc == fixed || size+argumentSize(command->argv[next]) <= limit)) {
+			size += argumentSize(command->argv[next]);
+			batch[batchArgc++] = command->argv[next++];
+		}
+		for (unsigned int i = end; i < command->argc; i++)
+			batch[batchArgc++] = command->argv[i];
+		batch[batchArgc] = NULL;
+		
+		pid_t pid = 0;
+		int batchStatus = 0;
+		if (launchCommand(batchArgc, batch, command->inputFD, command->outputFD, &pid) < 0)
+			break;
+		if (pid > 0 && waitpid(pid, &batchStatus, 0) > 0 && batchStatus != 0)
+			status = 1;
+	}
+	exit(status);
+}
+
+
+/********************************************************************************
+ * Function name  : static int launchBuiltinInChild(struct command_s *command, pid_t *childPID)
+ *     returns    : 0 on success, positive on failure
+ *         command   : pipeline stage running a builtin, with later stages after it
+ *         childPID  : set to the pid of the process running the builtin
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : fork a process to run a builtin that feeds another pipeline stage,
+ *                  so that it runs alongside the stages reading its output rather 
+ *                  than filling the pipe before they have been launched. the child
+ *                  exits with the builtin's status.
+ *
+ * NOTES          : as in other shells, cd, set and the like have no effect on the 
+ *                  shell itself when run as part of a pipeline.
+ ********************************************************************************/
+static int launchBuiltinInChild(struct command_s *command, pid_t *childPID) {
+	/* anything still buffered would otherwise be written by both processes */
+	fflush(NULL);
+	*childPID = fork();
+	if (*childPID < 0) {
+		perror("launchBuiltinInChild");
+		return 1;
+	}
+	else if (*childPID > 0) {
+		return 0;
+	}
+	
+	/* child. keep only this stage's descriptors open, so the later stages see EOF 
+	 * as soon as the builtin finishes */
+	for (struct command_s *stage = command->next; stage != NULL; stage = stage->next) {
+		if (stage->inputFD != fileno(stdin))
+			close(stage->inputFD);
+		if (stage->outputFD != fileno(stdout))
+			close(stage->outputFD);
+	}
+	pid_t pid = 0;
+	int status = 0;
+	if (launchCommand(command->argc, command->argv, command->inputFD, command->outputFD, &pid) > 0)
+		exit(1);
+	if (pid > 0) {
+		if (waitpid(pid, &status, 0) < 0)
+			exit(1);
+		exit(WIFEXITED(status) ? WEXITSTATUS(status) : 128+WTERMSIG(status));
+	}
+	exit(builtinStatus);
+}
+
+
+/********************************************************************************
+ * Function name  : static int execCommandInPlace(struct command_s *command, int argc, 
+ *												char **argv)
+ *     returns    : non zero. only returns if the exec failed
+ *         command   : command being run, whose descriptors argv is run against
+ *         argc      : Number of elements in argv.
+ *         argv      : Array of NULL terminated strings. command->argv, or part of it
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : replace the shell with argv. on failure, set lastExitStatus to 127
+ *                  and point command's descriptors at stdin and stdout.
+ *
+ * NOTES          : execInPlace() has already closed command's descriptors when it
+ *                  fails, so destroyCommand() must not close them again.
+ ********************************************************************************/
+static int execCommandInPlace(struct command_s *command, int argc, char **argv) {
+	int commandReturn = execInPlace(argc, argv, command->inputFD, command->outputFD);
+	command->inputFD = fileno(stdin);
+	command->outputFD = fileno(stdout);
+	lastExitStatus = 127;
+	return commandReturn;
+}
+
+
 /********************************************************************************
  * Function name  : int executeCommand(struct command_s *command)
  *     returns    : zero on success, non zero on error
@@ -218,6 +436,15 @@ struct command_s *interpretCommand(char *commandLine) {
  *                  builtins before attempting to run an  external executable
  *                  via fork/exec call.
  *
+ *                  every stage of the pipeline is launched before waiting on
+ *                  any of them, so stages run concurrently. builtins feeding a 
+ *                  later stage are fork()ed too. the exit status of the final 
+ *                  stage is left in lastExitStatus.
+ *
+ *                  while tracing is on, a trace record is written for each stage
+ *                  once every stage has been reaped. stages are reaped as they exit,
+ *                  in whatever order, so each one's wall time ends at its own exit.
+ *
  * NOTES          : TODO - free command automagically since we allocated it
  *                         here in the first place. user may or may not
  *                         understand exactly what structure fields have been 
@@ -227,14 +454,194 @@ int executeCommand(struct command_s *command) {
 	/* save stdin and stdout file descriptors for testing later on, 
 	 * and to save on some function calls */
 	int commandReturn = 0;
+	const struct builtin_s *builtin = command->argc > 1 ? findBuiltin(command->argv[0]) : NULL;
+	if (command->next == NULL && builtin != NULL && (builtin->flags & BUILTIN_EXEC)) {
+		/* exec on its own replaces the shell. only returns on failure */
+		return execCommandInPlace(command, command->argc-1, command->argv+1);
+	}
+	int stageCount = 0, launched = 0;
+	int lastStatus = 0;
+	pid_t lastPID = 0;
+	for (struct command_s *stage = command; stage != NULL; stage = stage->next)
+		stageCount++;
+	pid_t childPIDs[stageCount];
+	int childStages[stageCount];
+	/* decided once, as set trace=... can switch tracing part way through a pipeline */
+	int tracing = traceBuffer != NULL;
+	struct trace_record_s records[tracing ? stageCount : 1];
+	int traced = 0;
+	uint64_t pipelineID = traceNextPipeline();
+	
 	while (command != NULL && commandReturn >= 0) {
-		commandReturn = forkAndExecute(command->argc, command->argv, command->inputFD, command->outputFD);
+		pid_t pid = 0;
+		uint64_t launchTime = tracing ? traceNow() : 0;
+		if (command->next != NULL && isBuiltin(command->argv[0])) {
+			commandReturn = launchBuiltinInChild(command, &pid);
+		}
+		else if (execArgumentsFit(command->argc, command->argv)) {
+			commandReturn = launchCommand(command->argc, command->argv, command->inputFD, command->outputFD, &pid);
+		}
+		else if (shellArgBatch && command->fixedArgc < command->argc-command->trailingArgc) {
+			commandReturn = launchInBatches(command, &pid);
+		}
+		else if (shellArgBatch) {
+			/* only the matches of a pattern are split, so there is nothing to batch */
+			fprintf(stderr, "%s: argument list too long (%u arguments), and no pattern was expanded to split into batches\n",
+					command->argv[0], command->argc);
+			commandReturn = 1;
+		}
+		else {
+			fprintf(stderr, "%s: argument list too long (%u arguments). use set argbatch=on to run it in batches\n",
+					command->argv[0], command->argc);
+			commandReturn = 1;
+		}
+		if (tracing) {
+			struct trace_record_s *record = &records[traced];
+			memset(record, 0, sizeof(*record));
+			record->startTime = launchTime;
+			record->spawnLatency = traceNow()-launchTime;
+			record->pipelineID = pipelineID;
+			record->argvHash = traceHashArguments(command->argc, command->argv);
+			record->pid = pid;
+			record->stageIndex = traced;
+			/* builtins have finished by now */
+			record->wallTime = record->spawnLatency;
+			record->exitStatus = commandReturn > 0 ? 1 : (pid == 0 ? builtinStatus : 0);
+			traced++;
+		}
+		if (pid > 0) {
+			childStages[launched] = traced-1;
+			childPIDs[launched++] = pid;
+		}
+		if (command->next == NULL) {
+			lastPID = pid;
+			/* a builtin has already finished and left its status behind */
+			lastStatus = commandReturn > 0 ? 1 : (pid == 0 ? builtinStatus : 0);
+		}
+		/* the child has its own copies now. close ours so the next stage sees EOF 
+		 * as soon as this one exits */
+		if (command->inputFD != fileno(stdin))
+			close(command->inputFD);
+		if (command->outputFD != fileno(stdout))
+			close(command->outputFD);
+		command->inputFD = command->outputFD = -1;
 		command = command->next;
 	}
+	/* reap stages in the order they finish, so each is timed to its own exit */
+	for (int remaining = launched; remaining > 0; ) {
+		int status, i;
+		struct rusage usage;
+		pid_t pid = wait4(-1, &status, 0, &usage);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (i = 0; i < launched && childPIDs[i] != pid; i++);
+		if (i == launched)
+			continue;
+		remaining--;
+		int exitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : 128+WTERMSIG(status);
+		if (childPIDs[i] == lastPID)
+			lastStatus = exitStatus;
+		if (tracing && childStages[i] >= 0) {
+			struct trace_record_s *record = &records[childStages[i]];
+			record->wallTime = traceNow()-record->startTime;
+			record->userTime = (uint64_t)usage.ru_utime.tv_sec*1000000000+usage.ru_utime.tv_usec*1000;
+			record->systemTime = (uint64_t)usage.ru_stime.tv_sec*1000000000+usage.ru_stime.tv_usec*1000;
+			record->maxRSS = usage.ru_maxrss;
+			record->exitStatus = exitStatus;
+		}
+	}
+	for (int i = 0; i < traced; i++)
+		traceWrite(&records[i]);
+	lastExitStatus = lastStatus;
 	return commandReturn;
 }
 
 
+/********************************************************************************
+ * Function name  : int executeFinalCommand(struct command_s *command)
+ *     returns    : zero on success, non zero on error. does not return if the 
+ *                  command replaced the shell
+ *         command   : command_s structure as generated by interpretCommand(), known 
+ *                     to be the last command the shell will run
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : exec a simple external command in place of the shell, instead of
+ *                  fork()ing it and waiting for it only to exit straight after.
+ *                  pipelines, background tasks, builtins and commands that need
+ *                  running in batches go through executeCommand() as usual.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+int executeFinalCommand(struct command_s *command) {
+	if (command->next == NULL && !command->backgroundTask && !isBuiltin(command->argv[0]) &&
+		execArgumentsFit(command->argc, command->argv)) {
+		return execCommandInPlace(command, command->argc, command->argv);
+	}
+	return executeCommand(command);
+}
+
+
+/********************************************************************************
+ * Function name  : static int isBlankLine(const char *line)
+ *     returns    : 1 if line holds nothing but whitespace, otherwise 0
+ *         line      : NULL terminated line of a script
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : test whether interpretCommand() would find no command in line.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static int isBlankLine(const char *line) {
+	return line[strspn(line, " \t\r")] == '\0';
+}
+
+
+/********************************************************************************
+ * Function name  : int executeScript(char *script)
+ *     returns    : exit status of the last command run
+ *         script    : NULL terminated commands, one per line. modified in place.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : interpret and execute every line of script in turn, stopping early
+ *                  at exit or quit. the last command is run by executeFinalCommand(),
+ *                  so a script ending in a simple command never returns.
+ *
+ * NOTES          : used for -c strings and scripts sent to server mode.
+ ********************************************************************************/
+int executeScript(char *script) {
+	char *savePointer = NULL;
+	char *line = strtok_r(script, "\n", &savePointer);
+	while (line != NULL && isBlankLine(line))
+		line = strtok_r(NULL, "\n", &savePointer);
+	while (line != NULL) {
+		/* find the next command now, so the last one is known before it runs */
+		char *nextLine = strtok_r(NULL, "\n", &savePointer);
+		while (nextLine != NULL && isBlankLine(nextLine))
+			nextLine = strtok_r(NULL, "\n", &savePointer);
+		
+		struct command_s *command = interpretCommand(line);
+		if (command) {
+			int commandReturn = nextLine == NULL ? executeFinalCommand(command) : executeCommand(command);
+			destroyCommand(command);
+			if (commandReturn == -1)
+				break;
+		}
+		else {
+			fprintf(stderr,"error interpretting command\n");
+			lastExitStatus = 1;
+		}
+		line = nextLine;
+	}
+	return lastExitStatus;
+}
+
+
 /********************************************************************************
  * Function name  : int destroyCommand(struct command_s *command)
  *         command   : command structure to destroy by freeing all allocated
@@ -254,9 +661,10 @@ void destroyCommand(struct command_s *command) {
 			free(curCommand->argv[i]);
 		}
 		free(curCommand->argv);
-		if (curCommand->inputFD != fileno(stdin))
+		/* stages that were launched have already had their descriptors closed */
+		if (curCommand->inputFD >= 0 && curCommand->inputFD != fileno(stdin))
 			close(curCommand->inputFD);
-		if (curCommand->outputFD != fileno(stdout))
+		if (curCommand->outputFD >= 0 && curCommand->outputFD != fileno(stdout))
 			close(curCommand->outputFD);
 		curCommand = command->next;
 		free(command);
@@ -21,14 +21,20 @@
 struct command_s {
 	unsigned int argc; /* number of arguments in argv */
 	char **argv; /* array of string arguments to pass to utility */
+	unsigned int fixedArgc; /* arguments before the first expanded pattern, repeated in every batch */
+	unsigned int trailingArgc; /* arguments after the last expanded pattern, repeated at the end of every batch */
 	struct command_s *next; /* next command in command list */
 	int inputFD, outputFD; /* input and output file descriptors for stdio */
 	int backgroundTask; /* if 1, send this command to background and recover keyboard access */
 };
 
+extern int lastExitStatus; /* exit status of the last stage of the last command executed */
+
 int readCommandLine(char **command);
 struct command_s *interpretCommand(char *commandLine);
 int executeCommand(struct command_s *command);
+int executeFinalCommand(struct command_s *command);
+int executeScript(char *script);
 void destroyCommand(struct command_s *command);
 
 #endif
@@ -0,0 +1,517 @@
+/****************************************************************************************
+ * File name	: expand.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Pathname expansion of *, ? and [...] patterns in command arguments, and
+ *					argument list size accounting against ARG_MAX.
+ *
+ * NOTES		:	Patterns are compiled once per path component and matched without
+ *					backtracking beyond the most recent *, so a match costs at most
+ *					O(pattern * name) however many stars a pattern holds.
+ *					Each directory named by a pattern component is read exactly once.
+ ****************************************************************************************/
+
+#define _GNU_SOURCE /* strdup(), lstat() and d_type */
+
+#include "expand.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+extern char **environ;
+
+enum globTokenType_e {
+	GLOB_LITERAL,
+	GLOB_ANY,		/* ? */
+	GLOB_STAR,		/* * */
+	GLOB_CLASS		/* [...] */
+};
+
+struct globToken_s {
+	enum globTokenType_e type;
+	unsigned char literal;
+	unsigned char classBits[32]; /* one bit per byte value for GLOB_CLASS */
+};
+
+struct globPattern_s {
+	struct globToken_s *tokens;
+	int count;
+};
+
+struct globResult_s {
+	char **paths;
+	size_t count, capacity;
+};
+
+
+/********************************************************************************
+ * Function name  : int hasGlobCharacters(const char *argument)
+ *     returns    : 1 if argument contains a *, ? or [, otherwise 0
+ *         argument  : NULL terminated string to test
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : test whether argument needs pathname expansion.
+ *
+ * NOTES          : the shell has no quoting, and \ is an ordinary character here.
+ *                  a bracket expression such as [*] matches a pattern character 
+ *                  literally.
+ ********************************************************************************/
+int hasGlobCharacters(const char *argument) {
+	for (; *argument != '\0'; argument++) {
+		if (*argument == '*' || *argument == '?' || *argument == '[')
+			return 1;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int compilePattern(const char *pattern, size_t length,
+ *												struct globPattern_s *compiled)
+ *     returns    : zero on success, -1 on allocation failure
+ *         pattern   : one path component of a glob pattern. need not be NULL terminated.
+ *         length    : number of characters of pattern to compile
+ *         compiled  : filled with one token per character, star or bracket expression
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : translate pattern into a token array for matchPattern().
+ *
+ * NOTES          : consecutive stars are merged. a [ with no closing ] is a literal.
+ ********************************************************************************/
+static int compilePattern(const char *pattern, size_t length, struct globPattern_s *compiled) {
+	compiled->count = 0;
+	compiled->tokens = malloc(sizeof(struct globToken_s)*(length+1));
+	if (compiled->tokens == NULL)
+		return -1;
+
+	size_t i = 0;
+	while (i < length) {
+		struct globToken_s *token = &compiled->tokens[compiled->count];
+		switch (pattern[i]) {
+			case '*':
+				i++;
+				if (compiled->count > 0 && token[-1].type == GLOB_STAR)
+					continue;
+				token->type = GLOB_STAR;
+				break;
+			case '?':
+				token->type = GLOB_ANY;
+				i++;
+				break;
+			case '[': {
+				/* find the closing bracket. a ] straight after [ or [! is a member */
+				size_t end = i+1;
+				if (end < length && (pattern[end] == '!' || pattern[end] == '^'))
+					end++;
+				if (end < length && pattern[end] == ']')
+					end++;
+				while (end < length && pattern[end] != ']')
+					end++;
+				if (end >= length) {
+					token->type = GLOB_LITERAL;
+					token->literal = '[';
+					i++;
+					break;
+				}
+
+				int negate = 0;
+				size_t j = i+1;
+				if (pattern[j] == '!' || pattern[j] == '^') {
+					negate = 1;
+					j++;
+				}
+				memset(token->classBits, 0, sizeof(token->classBits));
+				while (j < end) {
+					unsigned char low = pattern[j], high = low;
+					if (j+2 < end && pattern[j+1] == '-') {
+						high = pattern[j+2];
+						j += 3;
+					}
+					else {
+						j++;
+					}
+					for (unsigned int c = low; c <= high; c++)
+						token->classBits[c >> 3] |= 1 << (c & 7);
+				}
+				if (negate) {
+					for (int k = 0; k < sizeof(token->classBits); k++)
+						token->classBits[k] = ~token->classBits[k];
+				}
+				token->type = GLOB_CLASS;
+				i = end+1;
+				break;
+			}
+			default:
+				token->type = GLOB_LITERAL;
+				token->literal = pattern[i];
+				i++;
+				break;
+		}
+		compiled->count++;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int matchPattern(const struct globPattern_s *compiled,
+ *											const char *name)
+ *     returns    : 1 if name matches the whole of compiled, otherwise 0
+ *         compiled  : pattern built by compilePattern()
+ *         name      : directory entry name to test
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : match name against compiled. a leading . in name is only matched
+ *                  by a literal . at the start of the pattern.
+ *
+ * NOTES          : only the most recent * is ever retried. any earlier * can absorb
+ *                  whatever the later one could, so nothing is lost by forgetting it.
+ ********************************************************************************/
+static int matchPattern(const struct globPattern_s *compiled, const char *name) {
+	const struct globToken_s *tokens = compiled->tokens;
+	int t = 0, starToken = -1;
+	size_t n = 0, starName = 0;
+
+	if (name[0] == '.' && (compiled->count == 0 || tokens[0].type != GLOB_LITERAL))
+		return 0;
+
+	while (name[n] != '\0') {
+		if (t < compiled->count) {
+			const struct globToken_s *token = &tokens[t];
+			unsigned char c = name[n];
+			if (token->type == GLOB_STAR) {
+				starToken = ++t;
+				starName = n;
+				continue;
+			}
+			if (token->type == GLOB_ANY ||
+				(token->type == GLOB_LITERAL && token->literal == c) ||
+				(token->type == GLOB_CLASS && (token->classBits[c >> 3] & (1 << (c & 7))))) {
+				t++;
+				n++;
+				continue;
+			}
+		}
+		if (starToken < 0)
+			return 0;
+		/* let the last star absorb one more character and try again from there */
+		t = starToken;
+		n = ++starName;
+	}
+	while (t < compiled->count && tokens[t].type == GLOB_STAR)
+		t++;
+	return t == compiled->count;
+}
+
+
+/********************************************************************************
+ * Function name  : static int reserveResults(struct globResult_s *result, size_t extra)
+ *     returns    : zero on success, -1 on allocation failure
+ *         result    : list of paths to grow
+ *         extra     : number of paths about to be appended
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : make sure result has room for extra more paths, doubling its
+ *                  capacity as required.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int reserveResults(struct globResult_s *result, size_t extra) {
+	if (result->count+extra <= result->capacity)
+		return 0;
+	size_t newCapacity = result->capacity ? result->capacity*2 : 64;
+	if (newCapacity < result->count+extra)
+		newCapacity = result->count+extra;
+	char **newPaths = realloc(result->paths, sizeof(char *)*newCapacity);
+	if (newPaths == NULL)
+		return -1;
+	result->paths = newPaths;
+	result->capacity = newCapacity;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int addResult(struct globResult_s *result, const char *path)
+ *     returns    : zero on success, -1 on allocation failure
+ *         result    : list of matched paths to append to
+ *         path      : path to copy onto the end of result
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : append a copy of path to result.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int addResult(struct globResult_s *result, const char *path) {
+	if (reserveResults(result, 1) != 0)
+		return -1;
+	if ((result->paths[result->count] = strdup(path)) == NULL)
+		return -1;
+	result->count++;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int expandPath(char *path, size_t pathLength, const char *rest,
+ *											struct globResult_s *result)
+ *     returns    : zero on success, -1 on allocation failure
+ *         path      : PATH_MAX buffer holding the directory matched so far
+ *         pathLength: number of characters in path
+ *         rest      : pattern components not yet matched
+ *         result    : receives every complete path matched
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : match the first component of rest inside path, then recurse for the
+ *                  remaining components.
+ *
+ * NOTES          : components without pattern characters are appended without reading
+ *                  the directory, and only checked for existence at the very end.
+ ********************************************************************************/
+static int expandPath(char *path, size_t pathLength, const char *rest, struct globResult_s *result) {
+	struct stat statBuffer;
+
+	/* copy leading slashes straight through */
+	while (*rest == '/') {
+		if (pathLength+1 >= PATH_MAX)
+			return 0;
+		path[pathLength++] = *rest++;
+	}
+	path[pathLength] = '\0';
+	if (*rest == '\0') {
+		/* end of pattern. paths built from literal components may not exist */
+		if (pathLength > 0 && stat(path, &statBuffer) == 0)
+			return addResult(result, path);
+		return 0;
+	}
+
+	size_t componentLength = strcspn(rest, "/");
+	const char *next = rest+componentLength;
+
+	if (!hasGlobCharacters(rest)) {
+		/* no pattern characters left anywhere in rest. check it exists as a whole */
+		if (pathLength+strlen(rest) >= PATH_MAX)
+			return 0;
+		strcpy(path+pathLength, rest);
+		if (lstat(path, &statBuffer) == 0)
+			return addResult(result, path);
+		return 0;
+	}
+
+	char component[componentLength+1];
+	memcpy(component, rest, componentLength);
+	component[componentLength] = '\0';
+	if (!hasGlobCharacters(component)) {
+		/* literal directory name in front of a later pattern */
+		if (pathLength+componentLength >= PATH_MAX)
+			return 0;
+		memcpy(path+pathLength, component, componentLength);
+		pathLength += componentLength;
+		return expandPath(path, pathLength, next, result);
+	}
+
+	struct globPattern_s compiled;
+	if (compilePattern(component, componentLength, &compiled) != 0)
+		return -1;
+	DIR *directory = opendir(pathLength > 0 ? path : ".");
+	if (directory == NULL) {
+		free(compiled.tokens);
+		return 0;
+	}
+
+	int toRet = 0;
+	struct dirent *entry;
+	while (toRet == 0 && (entry = readdir(directory)) != NULL) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		if (!matchPattern(&compiled, entry->d_name))
+			continue;
+		size_t nameLength = strlen(entry->d_name);
+		if (pathLength+nameLength >= PATH_MAX)
+			continue;
+		memcpy(path+pathLength, entry->d_name, nameLength+1);
+		if (*next == '\0') {
+			toRet = addResult(result, path);
+		}
+		else {
+#ifdef _DIRENT_HAVE_D_TYPE
+			/* skip entries that cannot hold the next component without a stat() */
+			if (entry->d_type != DT_DIR && entry->d_type != DT_LNK && entry->d_type != DT_UNKNOWN)
+				continue;
+#endif
+			toRet = expandPath(path, pathLength+nameLength, next, result);
+		}
+	}
+	closedir(directory);
+	free(compiled.tokens);
+	path[pathLength] = '\0';
+	return toRet;
+}
+
+
+static int compareStrings(const void *a, const void *b) {
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+
+/********************************************************************************
+ * Function name  : int expandGlobs(struct command_s *command)
+ *     returns    : zero on success, -1 on allocation failure
+ *         command   : single pipeline stage as built by interpretCommand()
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : replace every argument after argv[0] that contains pattern
+ *                  characters with the paths it matches, sorted by byte value.
+ *                  arguments matching nothing are passed through unchanged.
+ *
+ *                  command->fixedArgc is set to the number of arguments in front of
+ *                  the first expanded pattern, and command->trailingArgc to the 
+ *                  number after the last.
+ *
+ * NOTES          : strcmp() ordering is used rather than strcoll(), so the sort does
+ *                  not depend on locale and never needs to transform names.
+ ********************************************************************************/
+int expandGlobs(struct command_s *command) {
+	command->fixedArgc = command->argc;
+	command->trailingArgc = 0;
+
+	int needed = 0;
+	for (int i = 1; i < command->argc && !needed; i++)
+		needed = hasGlobCharacters(command->argv[i]);
+	if (!needed)
+		return 0;
+
+	struct globResult_s newArgv = { NULL, 0, 0 };
+	char *path = malloc(sizeof(char)*PATH_MAX);
+	if (path == NULL || addResult(&newArgv, command->argv[0]) != 0) {
+		perror("expandGlobs");
+		free(path);
+		return -1;
+	}
+
+	size_t expandedEnd = 0; /* newArgv.count after the last pattern's matches */
+	for (int i = 1; i < command->argc; i++) {
+		if (hasGlobCharacters(command->argv[i])) {
+			struct globResult_s matches = { NULL, 0, 0 };
+			if (expandPath(path, 0, command->argv[i], &matches) != 0) {
+				perror("expandGlobs");
+			}
+			else if (matches.count > 0) {
+				qsort(matches.paths, matches.count, sizeof(char *), compareStrings);
+				if (command->fixedArgc == command->argc)
+					command->fixedArgc = newArgv.count;
+				/* make room for every match at once then move the strings across */
+				if (reserveResults(&newArgv, matches.count) == 0) {
+					memcpy(newArgv.paths+newArgv.count, matches.paths, sizeof(char *)*matches.count);
+					newArgv.count += matches.count;
+					expandedEnd = newArgv.count;
+					free(matches.paths);
+					continue;
+				}
+				perror("expandGlobs");
+			}
+			for (size_t j = 0; j < matches.count; j++)
+				free(matches.paths[j]);
+			free(matches.paths);
+		}
+		/* not a pattern, or a pattern with no matches. keep the argument as written */
+		if (addResult(&newArgv, command->argv[i]) != 0)
+			perror("expandGlobs");
+	}
+	/* NULL terminate the new argv */
+	if (reserveResults(&newArgv, 1) != 0) {
+		perror("expandGlobs");
+		for (size_t j = 0; j < newArgv.count; j++)
+			free(newArgv.paths[j]);
+		free(newArgv.paths);
+		free(path);
+		return -1;
+	}
+	newArgv.paths[newArgv.count] = NULL;
+
+	for (int i = 0; i < command->argc; i++)
+		free(command->argv[i]);
+	free(command->argv);
+	free(path);
+	command->argv = newArgv.paths;
+	command->argc = newArgv.count;
+	if (expandedEnd > 0)
+		command->trailingArgc = newArgv.count-expandedEnd;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : size_t argumentSize(const char *argument)
+ *     returns    : bytes argument takes up in the argument area of a new process
+ *         argument  : NULL terminated argument or environment string
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : the string, its terminator and its pointer in argv or envp.
+ *
+ * NOTES          :
+ ********************************************************************************/
+size_t argumentSize(const char *argument) {
+	return strlen(argument)+1+sizeof(char *);
+}
+
+
+/********************************************************************************
+ * Function name  : long execArgumentLimit(void)
+ *     returns    : bytes left for argv strings and pointers in an execvp() call
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : ARG_MAX less the current environment and 2048 bytes of headroom,
+ *                  the same allowance POSIX xargs keeps.
+ *
+ * NOTES          :
+ ********************************************************************************/
+long execArgumentLimit(void) {
+	long limit = sysconf(_SC_ARG_MAX);
+	if (limit <= 0)
+		limit = _POSIX_ARG_MAX;
+	for (char **env = environ; env != NULL && *env != NULL; env++)
+		limit -= argumentSize(*env);
+	return limit-sizeof(char *)*2-2048;
+}
+
+
+/********************************************************************************
+ * Function name  : int execArgumentsFit(int argc, char **argv)
+ *     returns    : 1 if argv can be passed to execvp() without E2BIG, otherwise 0
+ *         argc      : Number of elements in argv.
+ *         argv      : Array of NULL terminated strings.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : compare the size of argv with execArgumentLimit().
+ *
+ * NOTES          :
+ ********************************************************************************/
+int execArgumentsFit(int argc, char **argv) {
+	long limit = execArgumentLimit();
+	long size = 0;
+	for (int i = 0; i < argc && size <= limit; i++)
+		size += argumentSize(argv[i]);
+	return size <= limit;
+}
@@ -0,0 +1,26 @@
+/****************************************************************************************
+ * File name	: expand.h
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Pathname expansion of *, ? and [...] patterns in command arguments, and
+ *					argument list size accounting against ARG_MAX.
+ *
+ * NOTES		:
+ ****************************************************************************************/
+
+#ifndef _EXPAND_H_
+#define _EXPAND_H_
+
+#include <stddef.h>
+#include "commands.h"
+
+int expandGlobs(struct command_s *command);
+int hasGlobCharacters(const char *argument);
+
+size_t argumentSize(const char *argument);
+long execArgumentLimit(void);
+int execArgumentsFit(int argc, char **argv);
+
+#endif
@@ -7,6 +7,7 @@
 //
 
 #include "kill.h"
+#include "builtin.h"
 #include <string.h>
 #include <limits.h>
 #include <signal.h>
@@ -38,6 +39,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 			if (inputPID > INT_MAX || inputPID == 0) {
 				const char *errormsg = "Invalid PID";
 				write(outputFD, errormsg, strlen(errormsg));
+				builtinStatus = 1;
 				return;
 			}
 			else {
@@ -53,6 +55,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 		  }
 		  else {
 		    perror("Invalid argument");
+		    builtinStatus = 1;
 		  }
 	}
 	else if (argc >= 3) {
@@ -64,6 +67,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 			if (signal > INT_MAX || signal == 0) {
 				const char *errormsg = "Invalid Signal";
 				write(outputFD, errormsg, strlen(errormsg));
+				builtinStatus = 1;
 				return;
 			}
 		  }
@@ -88,6 +92,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 			if (inputPID > INT_MAX || inputPID == 0) {
 				const char *errormsg = "Invalid PID";
 				write(outputFD, errormsg, strlen(errormsg));
+				builtinStatus = 1;
 				return;
 			}
 			else {
@@ -99,6 +104,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 		for (int i = 0; i < argc-2; i++) {
 			if (kill(pidlist[i], signal) != 0) {
 				perror("kill");
+				builtinStatus = 1;
 			}
 		}
 		free(pidlist);
@@ -106,6 +112,7 @@ void builtin_kill(int argc, char **argv, int inputFD, int outputFD) {
 	else {
 		const char *errormsg = "Error parsing arguments.\n";
 		write(outputFD, errormsg, strlen(errormsg));
+		builtinStatus = 1;
 	}
 }
 
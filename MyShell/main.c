@@ -7,17 +7,58 @@
  * Description	: Entry point for MyShell program. Runs a loop of reading command line 
  *					input, parsing and executing commands until quit command is given.
  *
+ *					usage: MyShell					- interactive
+ *						   MyShell <script>			- run each line of script
+ *						   MyShell -c <commands>	- run commands, one per line
+ *						   MyShell --server <socket>	- see server.h
+ *
  * NOTES		:	
  ****************************************************************************************/
 
+#define _GNU_SOURCE /* strdup(), pread() and fileno() */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/syscall.h>
 #include <sys/param.h>
 #include "builtin.h"
 #include "commands.h"
+#include "server.h"
+#include "trace.h"
+
+
+/********************************************************************************
+ * Function name  : static int atEndOfScript(int fd)
+ *     returns    : 1 if nothing but whitespace is left to read from fd, otherwise 0
+ *         fd        : script file being read by readCommandLine()
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : look ahead in the script, without moving its offset, to find
+ *                  whether the line just read holds the last command.
+ *
+ * NOTES          : readline() reads its input a byte at a time, so the file offset
+ *                  sits just past the line it returned. anything that is not a 
+ *                  regular file is never reported as ended.
+ ********************************************************************************/
+static int atEndOfScript(int fd) {
+	char buffer[512];
+	off_t offset = lseek(fd, 0, SEEK_CUR);
+	if (offset < 0)
+		return 0;
+	ssize_t length;
+	while ((length = pread(fd, buffer, sizeof(buffer), offset)) > 0) {
+		for (ssize_t i = 0; i < length; i++) {
+			if (buffer[i] != ' ' && buffer[i] != '\t' && buffer[i] != '\r' && buffer[i] != '\n')
+				return 0;
+		}
+		offset += length;
+	}
+	return length == 0;
+}
 
 
 int main (int argc, const char * argv[]) {
@@ -26,12 +67,31 @@ int main (int argc, const char * argv[]) {
 	char *commandLine;
 	FILE *inputFile = NULL;
 	int stdin_dup = -1, input_fd = -1;
-	if (argc == 2) {
+	/* tracing can be switched on from outside, for shells we do not start ourselves */
+	if (getenv("MYSHELL_TRACE") != NULL)
+	  traceOpen(getenv("MYSHELL_TRACE"));
+	if (argc == 3 && strcmp(argv[1], "--server") == 0) {
+	  /* serve scripts sent over the Unix socket at argv[2] until killed */
+	  return runServer(argv[2]);
+	}
+	else if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+	  /* run argv[2] as a script. its last command takes over this process */
+	  char *script = strdup(argv[2]);
+	  if (script == NULL) {
+	    perror("strdup");
+	    return 1;
+	  }
+	  return executeScript(script);
+	}
+	else if (argc == 2) {
 	  /* argv[1] is a script file */
 	  inputFile = fopen(argv[1], "r");
 	  if (inputFile != NULL) {
 	  input_fd = fileno(inputFile);
 	  stdin_dup = dup(STDIN_FILENO);
+	  /* keep the script and saved stdin out of every command we run */
+	  fcntl(input_fd, F_SETFD, FD_CLOEXEC);
+	  fcntl(stdin_dup, F_SETFD, FD_CLOEXEC);
 	  dup2(input_fd, STDIN_FILENO);
 	  }
 	  else {
@@ -43,18 +103,26 @@ int main (int argc, const char * argv[]) {
 	while ((commandReturn != -1) && (readCommandLine(&commandLine) != -1)) {
 		struct command_s *command = interpretCommand(commandLine);
 		if (command) {
-			commandReturn = executeCommand(command);
+			/* the last command of a script replaces the shell instead of being fork()ed */
+			if (inputFile != NULL && atEndOfScript(STDIN_FILENO))
+				commandReturn = executeFinalCommand(command);
+			else
+				commandReturn = executeCommand(command);
 			destroyCommand(command);
 			command = NULL;
 		}
 		else {
 			fprintf(stderr,"error interpretting command\n");
+			/* a failed expansion fails the command. blank lines do not count */
+			if (commandLine[strspn(commandLine, " \t\r\n")] != '\0')
+				lastExitStatus = 1;
 		}
 	free(commandLine);
 	}
 	if (inputFile != NULL) {
 	  dup2(stdin_dup, STDIN_FILENO);
 	  fclose(inputFile);
+	  return lastExitStatus;
 	}
     return 0;
 }
@@ -6,11 +6,408 @@
 //  Copyright 2012 xD-Duncesoft. All rights reserved.
 //
 
+#define _GNU_SOURCE /* fdopen() and strtok_r() */
+
 #include "ps.h"
 
 #include <stdlib.h>
+#include <ctype.h>
 #include <string.h>
 #include <dirent.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* the part of a process' stat file needed to place it in the process tree */
+struct ps_node_s {
+	int pid, ppid;
+	unsigned long cpuTime;		/* utime+stime of this process in clock ticks */
+	unsigned long subtreeTime;	/* cpuTime of this process and all of its descendants */
+	char commandName[32];
+};
+
+/* position of a process within a depth first walk of the tree */
+struct ps_visit_s {
+	int node, depth;
+};
+
+
+/* output formats for process rows */
+enum ps_format_e {
+	PS_FORMAT_TEXT,
+	PS_FORMAT_CSV,
+	PS_FORMAT_JSONL,
+	PS_FORMAT_BIN
+};
+
+/* columns selectable with -o */
+enum ps_field_e {
+	PS_FIELD_PID,
+	PS_FIELD_PPID,
+	PS_FIELD_PGRP,
+	PS_FIELD_SESSION,
+	PS_FIELD_TTY,
+	PS_FIELD_STATE,
+	PS_FIELD_TIME,
+	PS_FIELD_UTIME,
+	PS_FIELD_STIME,
+	PS_FIELD_MINFLT,
+	PS_FIELD_MAJFLT,
+	PS_FIELD_PRIORITY,
+	PS_FIELD_NICE,
+	PS_FIELD_THREADS,
+	PS_FIELD_FLAGS,
+	PS_FIELD_COMMAND,
+	PS_FIELD_COUNT
+};
+
+static const char *psFieldNames[PS_FIELD_COUNT] = {
+	"pid", "ppid", "pgrp", "session", "tty", "state", "time", "utime", "stime",
+	"minflt", "majflt", "priority", "nice", "threads", "flags", "command"
+};
+
+/* buffered output straight to a file descriptor, bypassing stdio formatting */
+struct ps_writer_s {
+	int fd;
+	size_t length;
+	char buffer[8192];
+};
+
+static const char digitPairs[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+
+static void writerFlush(struct ps_writer_s *writer) {
+	char *data = writer->buffer;
+	while (writer->length > 0) {
+		ssize_t written = write(writer->fd, data, writer->length);
+		if (written <= 0) {
+			perror("ps: write");
+			break;
+		}
+		data += written;
+		writer->length -= written;
+	}
+	writer->length = 0;
+}
+
+static void writerBytes(struct ps_writer_s *writer, const void *data, size_t length) {
+	if (writer->length+length > sizeof(writer->buffer))
+		writerFlush(writer);
+	if (length > sizeof(writer->buffer)) {
+		write(writer->fd, data, length);
+		return;
+	}
+	memcpy(writer->buffer+writer->length, data, length);
+	writer->length += length;
+}
+
+static void writerString(struct ps_writer_s *writer, const char *string) {
+	writerBytes(writer, string, strlen(string));
+}
+
+
+/********************************************************************************
+ * Function name  : static void writerUnsigned(struct ps_writer_s *writer, unsigned long value,
+ *												int minimumDigits)
+ *          writer        : buffer to append to.
+ *          value         : number to append in decimal.
+ *          minimumDigits : pad with leading zeros up to this many digits.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : append value in decimal, converting two digits at a time from a 
+ *                  lookup table instead of going through printf.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static void writerUnsigned(struct ps_writer_s *writer, unsigned long value, int minimumDigits) {
+	char digits[24];
+	char *start = digits+sizeof(digits);
+	while (value >= 100) {
+		const char *pair = &digitPairs[(value%100)*2];
+		value /= 100;
+		*--start = pair[1];
+		*--start = pair[0];
+	}
+	if (value >= 10) {
+		*--start = digitPairs[value*2+1];
+		*--start = digitPairs[value*2];
+	}
+	else {
+		*--start = '0'+value;
+	}
+	while (digits+sizeof(digits)-start < minimumDigits)
+		*--start = '0';
+	writerBytes(writer, start, digits+sizeof(digits)-start);
+}
+
+static void writerSigned(struct ps_writer_s *writer, long value) {
+	if (value < 0) {
+		writerBytes(writer, "-", 1);
+		writerUnsigned(writer, -(unsigned long)value, 1);
+	}
+	else {
+		writerUnsigned(writer, value, 1);
+	}
+}
+
+
+/********************************************************************************
+ * Function name  : static void writerQuoted(struct ps_writer_s *writer, const char *string,
+ *											enum ps_format_e format)
+ *          writer : buffer to append to.
+ *          string : text field to append.
+ *          format : PS_FORMAT_CSV or PS_FORMAT_JSONL quoting rules. text is appended as is.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : append string quoted for format. CSV fields are only quoted when
+ *                  they contain a comma, quote or line break.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static void writerQuoted(struct ps_writer_s *writer, const char *string, enum ps_format_e format) {
+	if (format == PS_FORMAT_CSV) {
+		if (strpbrk(string, ",\"\r\n") == NULL) {
+			writerString(writer, string);
+			return;
+		}
+		writerBytes(writer, "\"", 1);
+		for (const char *c = string; *c != '\0'; c++) {
+			if (*c == '"')
+				writerBytes(writer, "\"", 1);
+			writerBytes(writer, c, 1);
+		}
+		writerBytes(writer, "\"", 1);
+	}
+	else if (format == PS_FORMAT_JSONL) {
+		writerBytes(writer, "\"", 1);
+		for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; c++) {
+			if (*c == '"' || *c == '\\') {
+				writerBytes(writer, "\\", 1);
+				writerBytes(writer, c, 1);
+			}
+			else if (*c < 0x20) {
+				char escape[6] = { '\\', 'u', '0', '0', "0123456789abcdef"[*c >> 4], "0123456789abcdef"[*c & 0xF] };
+				writerBytes(writer, escape, sizeof(escape));
+			}
+			else {
+				writerBytes(writer, c, 1);
+			}
+		}
+		writerBytes(writer, "\"", 1);
+	}
+	else {
+		writerString(writer, string);
+	}
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseFieldList(char *list, enum ps_field_e *fields)
+ *		return : number of fields parsed, or -1 if list names an unknown field.
+ *          list   : comma separated field names, as given to -o.
+ *          fields : receives up to PS_FIELD_COUNT fields in the order given.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : translate the argument of -o into a list of columns.
+ *
+ * NOTES          : "comm" is accepted as another name for "command".
+ ********************************************************************************/
+static int parseFieldList(char *list, enum ps_field_e *fields) {
+	int count = 0;
+	char *savePointer = NULL;
+	for (char *name = strtok_r(list, ",", &savePointer); name != NULL; name = strtok_r(NULL, ",", &savePointer)) {
+		int field;
+		if (strcmp(name, "comm") == 0)
+			name = "command";
+		for (field = 0; field < PS_FIELD_COUNT && strcmp(name, psFieldNames[field]) != 0; field++);
+		if (field == PS_FIELD_COUNT || count == PS_FIELD_COUNT)
+			return -1;
+		fields[count++] = field;
+	}
+	return count;
+}
+
+
+/********************************************************************************
+ * Function name  : static void writeHeader(struct ps_writer_s *writer, enum ps_format_e format,
+ *											const enum ps_field_e *fields, int fieldCount)
+ *          writer     : buffer to append to.
+ *          format     : output format.
+ *          fields     : columns to print.
+ *          fieldCount : number of elements in fields.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : append the column headings for text and CSV, or the stream header
+ *                  for binary output. JSON lines carry their names in every record.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static void writeHeader(struct ps_writer_s *writer, enum ps_format_e format, 
+						const enum ps_field_e *fields, int fieldCount) {
+	if (format == PS_FORMAT_BIN) {
+		struct ps_record_header_s header;
+		memcpy(header.magic, PS_RECORD_MAGIC, sizeof(header.magic));
+		header.version = PS_RECORD_VERSION;
+		header.recordSize = sizeof(struct ps_record_s);
+		writerBytes(writer, &header, sizeof(header));
+	}
+	else if (format == PS_FORMAT_CSV) {
+		for (int i = 0; i < fieldCount; i++) {
+			if (i > 0)
+				writerBytes(writer, ",", 1);
+			writerString(writer, psFieldNames[fields[i]]);
+		}
+		writerBytes(writer, "\n", 1);
+	}
+	else if (format == PS_FORMAT_TEXT) {
+		for (int i = 0; i < fieldCount; i++) {
+			writerString(writer, i > 0 ? "\t " : "  ");
+			for (const char *c = psFieldNames[fields[i]]; *c != '\0'; c++) {
+				char upper = toupper(*c);
+				writerBytes(writer, &upper, 1);
+			}
+		}
+		writerBytes(writer, "\n", 1);
+	}
+}
+
+
+/********************************************************************************
+ * Function name  : static void writeProcess(struct ps_writer_s *writer, enum ps_format_e format,
+ *											const enum ps_field_e *fields, int fieldCount,
+ *											const struct ps_s *process)
+ *          writer     : buffer to append to.
+ *          format     : output format.
+ *          fields     : columns to print. ignored for binary output.
+ *          fieldCount : number of elements in fields.
+ *          process    : parsed stat file of the process to print.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : append one row, record or JSON object describing process.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static void writeProcess(struct ps_writer_s *writer, enum ps_format_e format, 
+						 const enum ps_field_e *fields, int fieldCount, const struct ps_s *process) {
+	if (format == PS_FORMAT_BIN) {
+		struct ps_record_s record;
+		memset(&record, 0, sizeof(record));
+		record.minflt = process->minflt;
+		record.cminflt = process->cminflt;
+		record.majflt = process->majflt;
+		record.cmajflt = process->cmajflt;
+		record.utime = process->utime;
+		record.stime = process->stime;
+		record.cutime = process->cutime;
+		record.cstime = process->cstime;
+		record.priority = process->priority;
+		record.nice = process->nice;
+		record.num_threads = process->num_threads;
+		record.pid = process->pid;
+		record.ppid = process->ppid;
+		record.pgrp = process->pgrp;
+		record.session = process->session;
+		record.tty_nr = process->tty_nr;
+		record.tpgid = process->tpgid;
+		record.flags = process->flags;
+		record.state = process->state;
+		strncpy(record.commandName, process->commandName, sizeof(record.commandName)-1);
+		writerBytes(writer, &record, sizeof(record));
+		return;
+	}
+	
+	if (format == PS_FORMAT_JSONL)
+		writerBytes(writer, "{", 1);
+	for (int i = 0; i < fieldCount; i++) {
+		if (format == PS_FORMAT_TEXT)
+			writerString(writer, i > 0 ? "\t " : " ");
+		else if (i > 0)
+			writerBytes(writer, ",", 1);
+		if (format == PS_FORMAT_JSONL) {
+			writerBytes(writer, "\"", 1);
+			writerString(writer, psFieldNames[fields[i]]);
+			writerBytes(writer, "\":", 2);
+		}
+		switch (fields[i]) {
+			case PS_FIELD_PID:		writerSigned(writer, process->pid); break;
+			case PS_FIELD_PPID:		writerSigned(writer, process->ppid); break;
+			case PS_FIELD_PGRP:		writerSigned(writer, process->pgrp); break;
+			case PS_FIELD_SESSION:	writerSigned(writer, process->session); break;
+			case PS_FIELD_UTIME:	writerUnsigned(writer, process->utime, 1); break;
+			case PS_FIELD_STIME:	writerUnsigned(writer, process->stime, 1); break;
+			case PS_FIELD_MINFLT:	writerUnsigned(writer, process->minflt, 1); break;
+			case PS_FIELD_MAJFLT:	writerUnsigned(writer, process->majflt, 1); break;
+			case PS_FIELD_PRIORITY:	writerSigned(writer, process->priority); break;
+			case PS_FIELD_NICE:		writerSigned(writer, process->nice); break;
+			case PS_FIELD_THREADS:	writerSigned(writer, process->num_threads); break;
+			case PS_FIELD_FLAGS:	writerUnsigned(writer, process->flags, 1); break;
+			case PS_FIELD_TTY:		writerQuoted(writer, process->ttyDeviceName, format); break;
+			case PS_FIELD_COMMAND:	writerQuoted(writer, process->commandName, format); break;
+			case PS_FIELD_STATE: {
+				char state[2] = { process->state, '\0' };
+				writerQuoted(writer, state, format);
+				break;
+			}
+			case PS_FIELD_TIME:
+				if (format == PS_FORMAT_JSONL)
+					writerBytes(writer, "\"", 1);
+				writerUnsigned(writer, process->hours, 2);
+				writerBytes(writer, ":", 1);
+				writerUnsigned(writer, process->mins, 2);
+				writerBytes(writer, ":", 1);
+				writerUnsigned(writer, process->secs, 2);
+				if (format == PS_FORMAT_JSONL)
+					writerBytes(writer, "\"", 1);
+				break;
+			default:
+				break;
+		}
+	}
+	writerString(writer, format == PS_FORMAT_JSONL ? "}\n" : "\n");
+}
+
+
+/********************************************************************************
+ * Function name  : static void writeProcessByPID(struct ps_writer_s *writer, 
+ *												enum ps_format_e format,
+ *												const enum ps_field_e *fields, int fieldCount,
+ *												int pid)
+ *          writer     : buffer to append to.
+ *          format     : output format.
+ *          fields     : columns to print.
+ *          fieldCount : number of elements in fields.
+ *          pid        : process or thread to print.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : parse /proc/<pid>/stat and append it with writeProcess().
+ *
+ * NOTES          : processes that exit before their stat file is read are skipped.
+ ********************************************************************************/
+static void writeProcessByPID(struct ps_writer_s *writer, enum ps_format_e format, 
+							  const enum ps_field_e *fields, int fieldCount, int pid) {
+	char procFileName[32];
+	snprintf(procFileName, sizeof(procFileName), "/proc/%d/stat", pid);
+	FILE *statFile = fopen(procFileName, "r");
+	if (statFile == NULL)
+		return;
+	struct ps_s *statContent = parseStatFile(statFile);
+	fclose(statFile);
+	if (statContent != NULL) {
+		writeProcess(writer, format, fields, fieldCount, statContent);
+		free(statContent);
+	}
+}
 
 
 /********************************************************************************
@@ -24,122 +421,173 @@
  * Date created   : 2/12/2012
  * Description    : Print process information to outputFD.
  *
- *					No arguments specified - print the stats of the current pid and any child 
- *												processes currently running
+ *					No arguments specified - print the stats of the current pid and each of
+ *												its threads, as listed in /proc/<pid>/task
+ *					-A						- print every running process
+ *					--tree					- print every running process as a tree under its
+ *												parent, with the CPU time of each subtree
+ *					--children <pid>		- print the tree of processes descended from pid
+ *					-o <field,...>			- choose the columns to print, from pid, ppid, 
+ *												pgrp, session, tty, state, time, utime, 
+ *												stime, minflt, majflt, priority, nice, 
+ *												threads, flags and command
+ *					--format=<format>		- text (default), csv, jsonl, or bin for the
+ *												fixed layout records described in ps.h
  *
- * NOTES          : 
+ * NOTES          : -o and --format do not apply to --tree or --children.
  ********************************************************************************/
 void builtin_ps(int argc, char **argv, int inputFD, int outputFD) {
-	FILE *output = fdopen(dup(outputFD), "w");
-	FILE *input = fdopen(dup(inputFD), "r");
-	struct ps_s *statContent;
-	int hours, mins, secs;
-	char *procFileName = malloc(sizeof(char)*PATH_MAX); /* allocate excess in case of long file structures */
-	for (int i = 0; i < PATH_MAX;i++, procFileName[i] = '\0');
-	
-	fprintf(output, "BUILTIN\n");	
-	if (argc == 1) {
-		int cpid = getpid(); /* current PID */
-		sprintf(procFileName, "/proc/%d/stat", cpid);
-		FILE *statFile = fopen(procFileName, "r");
-		if (statFile == NULL) {
-			perror("fopen");
-			return;
+	enum ps_field_e fields[PS_FIELD_COUNT] = { PS_FIELD_PID, PS_FIELD_TTY, PS_FIELD_TIME, PS_FIELD_COMMAND };
+	int fieldCount = 4, listAll = 0, fieldsGiven = 0;
+	enum ps_format_e format = PS_FORMAT_TEXT;
+	long treeRoot = -1; /* 0 for --tree, a pid for --children */
+	struct ps_writer_s *writer = malloc(sizeof(struct ps_writer_s));
+	if (writer == NULL) {
+		perror("ps");
+		builtinStatus = 1;
+		return;
+	}
+	writer->fd = outputFD;
+	writer->length = 0;
+	
+	for (int i = 1; i < argc; i++) {
+		const char *error = NULL;
+		if (strcmp(argv[i], "-A") == 0) {	/* list every running process */
+			listAll = 1;
 		}
-		sprintf(procFileName, "/proc/%d/task", cpid);
-		DIR *taskDir = opendir(procFileName);
-		if (taskDir == NULL) {
-			perror("opendir");
-			return;
+		else if (strcmp(argv[i], "--tree") == 0) {
+			treeRoot = 0;
 		}
-		
-		fprintf(output, "  PID\t TTY\t TIME\t COMMAND\n");
-		/* print initial pid before descending through child processes */
-		statContent = parseStatFile(statFile);
-		fprintf(output, " %d\t %s\t %02d:%02d:%02d  %s\n", statContent->pid, statContent->ttyDeviceName,
-				statContent->hours, statContent->mins, statContent->secs, statContent->commandName);
-		fclose(statFile);
-		
-		/* loop through every directory entry and get child pids from them
-		 * then print their stat files */
-		struct dirent *curDirent;
-		while ((curDirent = readdir(taskDir)) != NULL) {
-			int childPID;
-			if (sscanf(curDirent->d_name, "%d", &childPID) == 1 && childPID != cpid) {
-				sprintf(procFileName, "/proc/%d/stat", childPID);
-				statFile = fopen(procFileName, "r");
-				if (statFile == NULL) {
-					perror("fopen");
-					continue;
-				}
-				statContent = parseStatFile(statFile);
-				fprintf(output, " %d\t %s\t %02d:%02d:%02d  %s\n", statContent->pid, 
-						statContent->ttyDeviceName, statContent->hours, statContent->mins, 
-						statContent->secs, statContent->commandName);
-				fclose (statFile);
-			}
+		else if (strcmp(argv[i], "--children") == 0) {
+			char *end = NULL;
+			if (i+1 < argc)
+				treeRoot = strtol(argv[++i], &end, 10);
+			if (end == NULL || *end != '\0' || treeRoot <= 0 || treeRoot > INT_MAX)
+				error = "Invalid PID: ";
 		}
-		closedir(taskDir);
-	}
-	else if (argc == 2) {
-		if (strcmp(argv[1], "-A") == 0) {	/* list every running process */
-			fprintf(output, "  PID TTY\t TIME\t  COMMAND\n");
-			/* loop through every directory entry in /proc/ and get child pids from them
-			 * then print their stat files */
-			DIR *taskDir = opendir("/proc");
-			FILE *statFile = NULL;
-			struct dirent *curDirent;
-			while ((curDirent = readdir(taskDir)) != NULL) {
-				int childPID;
-				if (sscanf(curDirent->d_name, "%d", &childPID) == 1) {
-					sprintf(procFileName, "/proc/%d/stat", childPID);
-					statFile = fopen(procFileName, "r");
-					if (statFile == NULL) {
-						perror("fopen");
-						continue;
-					}
-					statContent = parseStatFile(statFile);
-					fprintf(output, " %d\t %s\t %02d:%02d:%02d  %s\n", statContent->pid, 
-							statContent->ttyDeviceName, statContent->hours, statContent->mins, 
-							statContent->secs, statContent->commandName);
-					fclose (statFile);
-				}
-			}
-			closedir(taskDir);
+		else if (strcmp(argv[i], "-o") == 0) {
+			if (i+1 >= argc || (fieldCount = parseFieldList(argv[++i], fields)) <= 0)
+				error = "Did not understand field list: ";
+			fieldsGiven = 1;
+		}
+		else if (strncmp(argv[i], "--format=", 9) == 0) {
+			const char *name = argv[i]+9;
+			if (strcmp(name, "text") == 0)
+				format = PS_FORMAT_TEXT;
+			else if (strcmp(name, "csv") == 0)
+				format = PS_FORMAT_CSV;
+			else if (strcmp(name, "jsonl") == 0)
+				format = PS_FORMAT_JSONL;
+			else if (strcmp(name, "bin") == 0)
+				format = PS_FORMAT_BIN;
+			else
+				error = "Did not understand format: ";
 		}
 		else {
-			fprintf(output, "Did not understand flag: %s", argv[1]);
+			error = "Did not understand flag: ";
+		}
+		/* errors go to stderr, never into a stream another program is parsing */
+		if (error != NULL) {
+			fprintf(stderr, "ps: %s%s\n", error, argv[i]);
+			builtinStatus = 1;
+			free(writer);
+			return;
 		}
 	}
+	
+	if (treeRoot >= 0) {
+		FILE *output = fdopen(dup(outputFD), "w");
+		if (output == NULL) {
+			perror("fdopen");
+			builtinStatus = 1;
+		}
+		else {
+			fprintf(output, "BUILTIN\n");
+			if (printProcessTree(output, (int)treeRoot) != 0) {
+				fprintf(stderr, "ps: No such process: %ld\n", treeRoot);
+				builtinStatus = 1;
+			}
+			fclose(output);
+		}
+		free(writer);
+		return;
+	}
+	if (format == PS_FORMAT_BIN && fieldsGiven) {
+		fprintf(stderr, "ps: -o does not apply to --format=bin\n");
+		builtinStatus = 1;
+		free(writer);
+		return;
+	}
+	
+	/* machine readable formats must start with their own header */
+	if (format == PS_FORMAT_TEXT)
+		writerString(writer, "BUILTIN\n");
+	writeHeader(writer, format, fields, fieldCount);
+	
+	/* loop through every directory entry and print the stat file of each numbered one */
+	char procFileName[32];
+	int cpid = getpid(); /* current PID */
+	if (!listAll) {
+		/* print initial pid before descending through its threads */
+		writeProcessByPID(writer, format, fields, fieldCount, cpid);
+		snprintf(procFileName, sizeof(procFileName), "/proc/%d/task", cpid);
+	}
+	DIR *procDir = opendir(listAll ? "/proc" : procFileName);
+	if (procDir == NULL) {
+		perror("opendir");
+		builtinStatus = 1;
+	}
 	else {
-		fprintf(output, "Too many arguments");
+		struct dirent *curDirent;
+		while ((curDirent = readdir(procDir)) != NULL) {
+			int childPID;
+			if (sscanf(curDirent->d_name, "%d", &childPID) == 1 && (listAll || childPID != cpid))
+				writeProcessByPID(writer, format, fields, fieldCount, childPID);
+		}
+		closedir(procDir);
 	}
-	fflush(output);
-	fclose(input);
-	fclose(output);
+	writerFlush(writer);
+	free(writer);
 }
 
 
 /********************************************************************************
  * Function name  : struct ps_s *parseStatFile(FILE *statFile)
- *		return : pointer to filled ps_s structure containing all data held in specified statFile.
+ *		return : pointer to filled ps_s structure containing all data held in specified statFile,
+ *					or NULL if statFile could not be parsed.
  *          statFile : Open file stream of the stat file in a pid's /proc folder.
  *
  * Created by     : James Johns
  * Date created   : 2/12/2012
  * Description    : parse statFile and return a pointer to the structure created.
  *
- * NOTES          : 
+ * NOTES          : the command name is taken from between the first '(' and the last ')',
+ *					so names containing spaces or brackets do not shift the later fields.
  ********************************************************************************/
 struct ps_s *parseStatFile(FILE *statFile) {
+	char line[1024];
+	if (fgets(line, sizeof(line), statFile) == NULL)
+		return NULL;
+	char *nameStart = strchr(line, '(');
+	char *nameEnd = strrchr(line, ')');
+	if (nameStart == NULL || nameEnd == NULL || nameEnd < nameStart)
+		return NULL;
+	
 	struct ps_s *toRet = malloc(sizeof(struct ps_s));
+	if (toRet == NULL)
+		return NULL;
+	toRet->pid = (int)strtol(line, NULL, 10);
+	memcpy(toRet->commandName, nameStart+1, nameEnd-nameStart-1);
+	toRet->commandName[nameEnd-nameStart-1] = '\0';
 	
-	fscanf(statFile, "%d %s %c %d %d %d %d %d %u %lu %lu %lu %lu %lu %lu %l %l %l %l %l %l",
-		   &toRet->pid, &toRet->commandName, &toRet->state, &toRet->ppid, &toRet->pgrp, 
-		   &toRet->session, &toRet->tty_nr, &toRet->tpgid, &toRet->flags, &toRet->minflt, 
-		   &toRet->cminflt, &toRet->majflt, &toRet->cmajflt, &toRet->utime, &toRet->stime, 
-		   &toRet->cutime, &toRet->cstime, &toRet->priority, &toRet->nice, &toRet->num_threads, 
-		   &toRet->itrealvalue);
+	if (sscanf(nameEnd+1, " %c %d %d %d %d %d %u %lu %lu %lu %lu %lu %lu %ld %ld %ld %ld %ld %ld",
+			   &toRet->state, &toRet->ppid, &toRet->pgrp, &toRet->session, &toRet->tty_nr, 
+			   &toRet->tpgid, &toRet->flags, &toRet->minflt, &toRet->cminflt, &toRet->majflt, 
+			   &toRet->cmajflt, &toRet->utime, &toRet->stime, &toRet->cutime, &toRet->cstime, 
+			   &toRet->priority, &toRet->nice, &toRet->num_threads, &toRet->itrealvalue) != 19) {
+		free(toRet);
+		return NULL;
+	}
 	
 	toRet->hours = (int) ((toRet->stime+toRet->utime))/360000;
 	toRet->mins = (int) ((toRet->stime+toRet->utime)%360000)/6000;
@@ -163,3 +611,240 @@ struct ps_s *parseStatFile(FILE *statFile) {
 
 	return toRet;
 }
+
+
+/********************************************************************************
+ * Function name  : static int readProcessNode(int pid, struct ps_node_s *node)
+ *		return : 0 on success, -1 if the process could not be read.
+ *          pid  : process to read /proc/<pid>/stat of.
+ *          node : filled with the pid, parent, CPU time and name of the process.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : read just the fields of the stat file the process tree needs,
+ *                  without allocating.
+ *
+ * NOTES          : the command name is found from the last ')' so that names 
+ *                  containing spaces or brackets do not shift the later fields.
+ ********************************************************************************/
+static int readProcessNode(int pid, struct ps_node_s *node) {
+	char buffer[512];
+	char path[32];
+	snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	ssize_t length = read(fd, buffer, sizeof(buffer)-1);
+	close(fd);
+	if (length <= 0)
+		return -1;
+	buffer[length] = '\0';
+	
+	char *nameStart = strchr(buffer, '(');
+	char *nameEnd = strrchr(buffer, ')');
+	if (nameStart == NULL || nameEnd == NULL || nameEnd < nameStart)
+		return -1;
+	size_t nameLength = nameEnd-nameStart-1;
+	if (nameLength >= sizeof(node->commandName))
+		nameLength = sizeof(node->commandName)-1;
+	memcpy(node->commandName, nameStart+1, nameLength);
+	node->commandName[nameLength] = '\0';
+	
+	unsigned long utime, stime;
+	if (sscanf(nameEnd+1, " %*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", 
+			   &node->ppid, &utime, &stime) != 3)
+		return -1;
+	node->pid = pid;
+	node->cpuTime = node->subtreeTime = utime+stime;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static void formatTicks(char *buffer, size_t size, unsigned long ticks)
+ *          buffer : receives ticks formatted as HH:MM:SS.
+ *          size   : number of bytes available in buffer.
+ *          ticks  : CPU time in clock ticks.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : format a CPU time the same way as the TIME column.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static void formatTicks(char *buffer, size_t size, unsigned long ticks) {
+	long ticksPerSecond = sysconf(_SC_CLK_TCK);
+	unsigned long seconds = ticks/(ticksPerSecond > 0 ? ticksPerSecond : 100);
+	snprintf(buffer, size, "%02lu:%02lu:%02lu", seconds/3600, (seconds%3600)/60, seconds%60);
+}
+
+
+/********************************************************************************
+ * Function name  : static int findNode(const int *table, unsigned int mask, 
+ *										const struct ps_node_s *nodes, int pid)
+ *		return : index into nodes of process pid, or -1 if pid was not found.
+ *          table  : open addressed pid -> node index map. -1 marks an empty slot.
+ *          mask   : number of slots in table minus one. table size is a power of two.
+ *          nodes  : processes indexed by table.
+ *          pid    : process to look up.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : linear probe from pid's hash until pid or an empty slot is found.
+ *
+ * NOTES          : table is kept at most half full, so probes stay short.
+ ********************************************************************************/
+static int findNode(const int *table, unsigned int mask, const struct ps_node_s *nodes, int pid) {
+	for (unsigned int i = ((unsigned int)pid*2654435761u) & mask; table[i] >= 0; i = (i+1) & mask) {
+		if (nodes[table[i]].pid == pid)
+			return table[i];
+	}
+	return -1;
+}
+
+
+/********************************************************************************
+ * Function name  : int printProcessTree(FILE *output, int rootPID)
+ *		return : 0 on success, -1 if rootPID is not running or /proc could not be read.
+ *          output  : stream to print the tree to.
+ *          rootPID : process to print the subtree of, or 0 to print every process.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : print processes indented beneath their parents, alongside the
+ *                  CPU time of each process and of its whole subtree.
+ *
+ * NOTES          : /proc is scanned once into a flat array. children are then 
+ *                  indexed in compressed sparse row form: children[offsets[i]] up to 
+ *                  children[offsets[i+1]] are the children of node i. building the 
+ *                  index, summing subtree times and printing are each linear in the 
+ *                  number of processes, and only a handful of arrays are allocated.
+ *                  pids are looked up in a hash table of about twice as many slots
+ *                  as processes, however large pid_max is.
+ ********************************************************************************/
+int printProcessTree(FILE *output, int rootPID) {
+	struct ps_node_s *nodes = NULL;
+	int count = 0, capacity = 0;
+	
+	DIR *procDir = opendir("/proc");
+	if (procDir == NULL) {
+		perror("opendir");
+		return -1;
+	}
+	struct dirent *curDirent;
+	while ((curDirent = readdir(procDir)) != NULL) {
+		int pid;
+		if (sscanf(curDirent->d_name, "%d", &pid) != 1)
+			continue;
+		if (count == capacity) {
+			capacity = capacity ? capacity*2 : 1024;
+			struct ps_node_s *grown = realloc(nodes, sizeof(struct ps_node_s)*capacity);
+			if (grown == NULL) {
+				perror("printProcessTree");
+				break;
+			}
+			nodes = grown;
+		}
+		/* processes may exit between readdir() and open(). skip them */
+		if (readProcessNode(pid, &nodes[count]) == 0)
+			count++;
+	}
+	closedir(procDir);
+	
+	/* pid -> node lookup, then count children into offsets[parent+1] */
+	unsigned int tableSize = 16;
+	while (tableSize < (unsigned int)count*2)
+		tableSize *= 2;
+	unsigned int mask = tableSize-1;
+	int *indexOf = malloc(sizeof(int)*tableSize);
+	int *offsets = calloc(count+1, sizeof(int));
+	int *children = malloc(sizeof(int)*(count+1));
+	int *parentOf = malloc(sizeof(int)*(count+1));
+	struct ps_visit_s *order = malloc(sizeof(struct ps_visit_s)*(count+1));
+	struct ps_visit_s *stack = malloc(sizeof(struct ps_visit_s)*(count+1));
+	int toRet = -1;
+	if (indexOf == NULL || offsets == NULL || children == NULL || parentOf == NULL || order == NULL ||
+		stack == NULL) {
+		perror("printProcessTree");
+		goto cleanup;
+	}
+	for (unsigned int i = 0; i < tableSize; i++)
+		indexOf[i] = -1;
+	for (int i = 0; i < count; i++) {
+		unsigned int slot = ((unsigned int)nodes[i].pid*2654435761u) & mask;
+		while (indexOf[slot] >= 0)
+			slot = (slot+1) & mask;
+		indexOf[slot] = i;
+	}
+	for (int i = 0; i < count; i++) {
+		int ppid = nodes[i].ppid;
+		parentOf[i] = (ppid > 0 && ppid != nodes[i].pid) ? findNode(indexOf, mask, nodes, ppid) : -1;
+		if (parentOf[i] >= 0)
+			offsets[parentOf[i]+1]++;
+	}
+	for (int i = 0; i < count; i++)
+		offsets[i+1] += offsets[i];
+	/* fill children in pid order, with stack[] borrowed as the write cursor of each parent */
+	for (int i = 0; i < count; i++)
+		stack[i].node = offsets[i];
+	for (int i = 0; i < count; i++) {
+		if (parentOf[i] >= 0)
+			children[stack[parentOf[i]].node++] = i;
+	}
+	
+	/* depth first walk from the roots, recording the visiting order. every process 
+	 * has one parent, so each is pushed at most once and the stack never overflows */
+	int top = 0, visited = 0;
+	if (rootPID > 0) {
+		stack[top].node = findNode(indexOf, mask, nodes, rootPID);
+		if (stack[top].node < 0)
+			goto cleanup;
+		stack[top++].depth = 0;
+	}
+	else {
+		/* push roots in reverse so the lowest pid is visited first */
+		for (int i = count-1; i >= 0; i--) {
+			if (parentOf[i] < 0) {
+				stack[top].node = i;
+				stack[top++].depth = 0;
+			}
+		}
+	}
+	while (top > 0) {
+		struct ps_visit_s visit = stack[--top];
+		order[visited++] = visit;
+		for (int c = offsets[visit.node+1]-1; c >= offsets[visit.node]; c--) {
+			stack[top].node = children[c];
+			stack[top++].depth = visit.depth+1;
+		}
+	}
+	
+	/* children are always visited after their parent, so walking the order backwards
+	 * completes every subtree before its total is added to the parent */
+	for (int i = visited-1; i > 0; i--) {
+		int node = order[i].node;
+		if (order[i].depth > 0)
+			nodes[parentOf[node]].subtreeTime += nodes[node].subtreeTime;
+	}
+	
+	fprintf(output, "  PID\t PPID\t TIME\t  SUBTREE  COMMAND\n");
+	for (int i = 0; i < visited; i++) {
+		struct ps_node_s *node = &nodes[order[i].node];
+		char cpuTime[32], subtreeTime[32];
+		formatTicks(cpuTime, sizeof(cpuTime), node->cpuTime);
+		formatTicks(subtreeTime, sizeof(subtreeTime), node->subtreeTime);
+		fprintf(output, " %d\t %d\t %s  %s  %*s%s%s\n", node->pid, node->ppid, cpuTime, subtreeTime, 
+				order[i].depth*2, "", order[i].depth > 0 ? "\\_ " : "", node->commandName);
+	}
+	toRet = 0;
+	
+cleanup:
+	free(stack);
+	free(order);
+	free(parentOf);
+	free(children);
+	free(offsets);
+	free(indexOf);
+	free(nodes);
+	return toRet;
+}
@@ -10,6 +10,7 @@
 #define _PS_H_
 
 #include <stdio.h>
+#include <stdint.h>
 #include "builtin.h"
 
 struct ps_s {
@@ -27,7 +28,31 @@ struct ps_s {
 	char ttyDeviceName[50];
 };
 
+/* ps --format=bin writes one ps_record_header_s, then one ps_record_s per process.
+ * all fields are in host byte order. the header's version reads as 0x0100 when 
+ * decoded with the wrong byte order. fields are ordered widest first so the 
+ * layout has no padding */
+#define PS_RECORD_MAGIC "MSPS"
+#define PS_RECORD_VERSION 1
+
+struct ps_record_header_s {
+	char magic[4];			/* PS_RECORD_MAGIC */
+	uint16_t version;		/* PS_RECORD_VERSION */
+	uint16_t recordSize;	/* sizeof(struct ps_record_s) */
+};
+
+struct ps_record_s {
+	uint64_t minflt, cminflt, majflt, cmajflt, utime, stime; /* utime and stime in clock ticks */
+	int64_t cutime, cstime, priority, nice, num_threads;
+	int32_t pid, ppid, pgrp, session, tty_nr, tpgid;
+	uint32_t flags;
+	char state;
+	char reserved[3];
+	char commandName[16];	/* NULL padded, truncated to the kernel's 15 character limit */
+};
+
 void builtin_ps(int argc, char **argv, int inputFD, int outputFD);
 struct ps_s *parseStatFile(FILE *statFile);
+int printProcessTree(FILE *output, int rootPID);
 
 #endif
@@ -0,0 +1,357 @@
+/****************************************************************************************
+ * File name	: server.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Server mode. Accepts scripts over a local Unix socket and runs each one
+ *					in its own child process, streaming its output back to the client.
+ *
+ * NOTES		:	Every connection is handled by a fork()ed child, so requests run
+ *					concurrently and each starts from a snapshot of the server's working
+ *					directory and environment. cd or set in one request cannot leak into
+ *					another.
+ ****************************************************************************************/
+
+#define _GNU_SOURCE /* pipe2(), accept4() and lstat() */
+
+#include "server.h"
+#include "commands.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+
+/********************************************************************************
+ * Function name  : static int createPipe(int pipeFDs[2])
+ *     returns    : zero on success, -1 on failure with errno set
+ *         pipeFDs   : receives the read end and write end of the new pipe
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : create a close-on-exec pipe, so commands the script runs do not 
+ *                  inherit the ends of other connections.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static int createPipe(int pipeFDs[2]) {
+#ifdef __linux__
+	return pipe2(pipeFDs, O_CLOEXEC);
+#else
+	if (pipe(pipeFDs) == -1)
+		return -1;
+	fcntl(pipeFDs[0], F_SETFD, FD_CLOEXEC);
+	fcntl(pipeFDs[1], F_SETFD, FD_CLOEXEC);
+	return 0;
+#endif
+}
+
+
+/********************************************************************************
+ * Function name  : static int acceptConnection(int listenFD)
+ *     returns    : close-on-exec socket of the new connection, or -1 on error
+ *         listenFD  : listening socket
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : accept the next connection on listenFD.
+ *
+ * NOTES          : 
+ ********************************************************************************/
+static int acceptConnection(int listenFD) {
+#ifdef __linux__
+	return accept4(listenFD, NULL, NULL, SOCK_CLOEXEC);
+#else
+	int connection = accept(listenFD, NULL, NULL);
+	if (connection >= 0)
+		fcntl(connection, F_SETFD, FD_CLOEXEC);
+	return connection;
+#endif
+}
+
+
+/********************************************************************************
+ * Function name  : static int sendFrame(int connection, uint32_t type, char *frame,
+ *										size_t length)
+ *     returns    : zero on success, -1 if the client has gone away
+ *         connection: socket connected to the client
+ *         type      : SERVER_FRAME_* type of the frame
+ *         frame     : buffer of SERVER_FRAME_HEADER_SIZE bytes followed by the payload
+ *         length    : number of payload bytes after the header
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : fill in the frame header and write header and payload together.
+ *
+ * NOTES          : the caller reads output straight into frame after the header,
+ *                  so each frame costs a single write() in the common case.
+ ********************************************************************************/
+static int sendFrame(int connection, uint32_t type, char *frame, size_t length) {
+	uint32_t header[2] = { htonl(type), htonl((uint32_t)length) };
+	memcpy(frame, header, SERVER_FRAME_HEADER_SIZE);
+	length += SERVER_FRAME_HEADER_SIZE;
+	while (length > 0) {
+		ssize_t written = write(connection, frame, length);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		frame += written;
+		length -= written;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static char *readRequest(int connection)
+ *     returns    : malloc'd, NULL terminated script sent by the client, or NULL on error
+ *         connection: socket connected to the client
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : read everything the client sends until it shuts down its side.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static char *readRequest(int connection) {
+	size_t length = 0, capacity = 4096;
+	char *request = malloc(capacity);
+	while (request != NULL) {
+		if (length+1 == capacity) {
+			char *grown = realloc(request, capacity*2);
+			if (grown == NULL)
+				break;
+			request = grown;
+			capacity *= 2;
+		}
+		ssize_t received = read(connection, request+length, capacity-length-1);
+		if (received == 0) {
+			request[length] = '\0';
+			return request;
+		}
+		if (received < 0 && errno != EINTR)
+			break;
+		if (received > 0)
+			length += received;
+	}
+	perror("readRequest");
+	free(request);
+	return NULL;
+}
+
+
+/********************************************************************************
+ * Function name  : static int serveConnection(int connection)
+ *     returns    : zero once the whole reply has been sent, non zero on error
+ *         connection: socket connected to the client
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : read a script from connection, run it in a child process with its
+ *                  stdout and stderr on pipes, and forward everything written to them
+ *                  as frames until both close. finish with an exit status frame.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int serveConnection(int connection) {
+	char *script = readRequest(connection);
+	if (script == NULL)
+		return 1;
+
+	int outPipe[2], errPipe[2];
+	if (createPipe(outPipe) == -1 || createPipe(errPipe) == -1) {
+		perror("serveConnection: pipe");
+		return 1;
+	}
+	pid_t pid = fork();
+	if (pid == 0) {
+		/* child. the script runs against the pipes and gets no input of its own. 
+		 * commands it runs should still die of SIGPIPE as usual */
+		signal(SIGPIPE, SIG_DFL);
+		int nullFD = open("/dev/null", O_RDONLY);
+		dup2(nullFD, STDIN_FILENO);
+		dup2(outPipe[1], STDOUT_FILENO);
+		dup2(errPipe[1], STDERR_FILENO);
+		close(nullFD);
+		exit(executeScript(script));
+	}
+	close(outPipe[1]);
+	close(errPipe[1]);
+	free(script);
+	if (pid < 0) {
+		perror("serveConnection: fork");
+		return 1;
+	}
+
+	char *frame = malloc(SERVER_FRAME_HEADER_SIZE+SERVER_FRAME_MAX_PAYLOAD);
+	struct pollfd pollFDs[2] = {
+		{ outPipe[0], POLLIN, 0 },
+		{ errPipe[0], POLLIN, 0 }
+	};
+	uint32_t frameTypes[2] = { SERVER_FRAME_STDOUT, SERVER_FRAME_STDERR };
+	int openPipes = 2, clientGone = (frame == NULL);
+	while (openPipes > 0 && !clientGone) {
+		if (poll(pollFDs, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (int i = 0; i < 2; i++) {
+			if (pollFDs[i].fd < 0 || pollFDs[i].revents == 0)
+				continue;
+			ssize_t length = read(pollFDs[i].fd, frame+SERVER_FRAME_HEADER_SIZE, SERVER_FRAME_MAX_PAYLOAD);
+			if (length > 0) {
+				if (sendFrame(connection, frameTypes[i], frame, length) != 0)
+					clientGone = 1;
+			}
+			else if (length == 0 || errno != EINTR) {
+				close(pollFDs[i].fd);
+				pollFDs[i].fd = -1;
+				openPipes--;
+			}
+		}
+	}
+	/* if the client went away, stop the script rather than let it block on a full pipe */
+	if (clientGone)
+		kill(pid, SIGTERM);
+
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+	uint32_t exitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : 128+WTERMSIG(status);
+	exitStatus = htonl(exitStatus);
+	int toRet = 1;
+	if (frame != NULL && !clientGone) {
+		memcpy(frame+SERVER_FRAME_HEADER_SIZE, &exitStatus, sizeof(exitStatus));
+		toRet = sendFrame(connection, SERVER_FRAME_EXIT, frame, sizeof(exitStatus)) != 0;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (pollFDs[i].fd >= 0)
+			close(pollFDs[i].fd);
+	}
+	free(frame);
+	return toRet;
+}
+
+
+/********************************************************************************
+ * Function name  : static void reapConnections(int signalNumber)
+ *         signalNumber : SIGCHLD
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : reap every connection handler that has finished, so that an idle
+ *                  server does not keep zombies around.
+ *
+ * NOTES          : errno is preserved for the code the signal interrupted.
+ ********************************************************************************/
+static void reapConnections(int signalNumber) {
+	int savedErrno = errno;
+	while (waitpid(-1, NULL, WNOHANG) > 0);
+	errno = savedErrno;
+}
+
+
+/********************************************************************************
+ * Function name  : int runServer(const char *socketPath)
+ *     returns    : non zero if the socket could not be set up. otherwise never returns
+ *         socketPath: filesystem path to create the listening Unix socket at
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : listen on socketPath and fork a child to serve each connection.
+ *                  a stale socket left at socketPath is replaced. any other file
+ *                  there is left alone and the server does not start.
+ *
+ * NOTES          : finished children are reaped by reapConnections() on SIGCHLD. a 
+ *                  socket left at socketPath is only replaced if nothing is listening
+ *                  on it.
+ ********************************************************************************/
+int runServer(const char *socketPath) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "runServer: socket path too long: %s\n", socketPath);
+		return 1;
+	}
+	strcpy(address.sun_path, socketPath);
+
+	/* replace a stale socket, but never a live one or anything else found at socketPath */
+	struct stat statBuffer;
+	if (lstat(socketPath, &statBuffer) == 0) {
+		if (!S_ISSOCK(statBuffer.st_mode)) {
+			fprintf(stderr, "runServer: %s exists and is not a socket\n", socketPath);
+			return 1;
+		}
+		int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+		int probeError = 0;
+		if (probe < 0 || connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0)
+			probeError = probe < 0 ? errno : EADDRINUSE;
+		else if (errno != ECONNREFUSED)
+			probeError = errno;
+		if (probe >= 0)
+			close(probe);
+		if (probeError == EADDRINUSE) {
+			fprintf(stderr, "runServer: a server is already listening on %s\n", socketPath);
+			return 1;
+		}
+		else if (probeError != 0) {
+			fprintf(stderr, "runServer: %s: %s\n", socketPath, strerror(probeError));
+			return 1;
+		}
+		unlink(socketPath);
+	}
+	int listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFD < 0) {
+		perror("runServer: socket");
+		return 1;
+	}
+	fcntl(listenFD, F_SETFD, FD_CLOEXEC);
+	if (bind(listenFD, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listenFD, SOMAXCONN) != 0) {
+		perror("runServer: bind");
+		close(listenFD);
+		return 1;
+	}
+	/* a client hanging up mid reply must not kill the connection handler */
+	signal(SIGPIPE, SIG_IGN);
+	/* reap connection handlers as they finish, even while no client connects */
+	struct sigaction childAction;
+	memset(&childAction, 0, sizeof(childAction));
+	childAction.sa_handler = reapConnections;
+	childAction.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigemptyset(&childAction.sa_mask);
+	sigaction(SIGCHLD, &childAction, NULL);
+
+	for (;;) {
+		int connection = acceptConnection(listenFD);
+		if (connection < 0) {
+			if (errno != EINTR && errno != ECONNABORTED)
+				perror("runServer: accept");
+			continue;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			/* the handler must wait for its own script runner, not have it reaped */
+			signal(SIGCHLD, SIG_DFL);
+			close(listenFD);
+			exit(serveConnection(connection));
+		}
+		else if (pid < 0) {
+			perror("runServer: fork");
+		}
+		close(connection);
+	}
+}
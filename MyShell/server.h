@@ -0,0 +1,40 @@
+/****************************************************************************************
+ * File name	: server.h
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Server mode. Accepts scripts over a local Unix socket and runs each one
+ *					in its own child process, streaming its output back to the client.
+ *
+ * NOTES		:	Protocol - the client writes the whole script, one command per line,
+ *					then shuts down its writing side of the socket. The server replies with
+ *					a stream of frames, each an 8 byte header followed by length bytes of
+ *					payload:
+ *
+ *						uint32_t type	- SERVER_FRAME_* in network byte order
+ *						uint32_t length	- payload length in network byte order
+ *
+ *					SERVER_FRAME_EXIT is always the last frame. its payload is the exit
+ *					status of the script as a uint32_t in network byte order.
+ *
+ *					Only the script is sent. Every request runs in the working directory
+ *					and environment the server was started with, not the client's, and
+ *					changes one request makes to them do not carry over to the next.
+ ****************************************************************************************/
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stdint.h>
+
+#define SERVER_FRAME_STDOUT 1
+#define SERVER_FRAME_STDERR 2
+#define SERVER_FRAME_EXIT 3
+
+#define SERVER_FRAME_HEADER_SIZE 8
+#define SERVER_FRAME_MAX_PAYLOAD 65536
+
+int runServer(const char *socketPath);
+
+#endif
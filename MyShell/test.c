@@ -0,0 +1,419 @@
+/****************************************************************************************
+ * File name	: test.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: The test, [ and [[ builtins.
+ *
+ *					expression	: or
+ *					or			: and [ -o and ]...
+ *					and			: not [ -a not ]...
+ *					not			: ! not | primary
+ *					primary		: ( expression ) | unary-op word | word binary-op word | word
+ *
+ *					[[ also accepts && for -a and || for -o.
+ *
+ * NOTES		:	File predicates use fstatat() and faccessat() relative to the working
+ *					directory, with the effective user and group ids, as test(1) does.
+ *					A word followed by a binary operator is always read as a comparison,
+ *					so [ -f = -f ] compares two strings.
+ ****************************************************************************************/
+
+#define _GNU_SOURCE /* fstatat(), faccessat() and st_mtim */
+
+#include "test.h"
+#include "builtin.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+struct testParser_s {
+	char **argv;
+	int position;		/* next argument to read */
+	int end;			/* index after the last argument of the expression */
+	int doubleBracket;	/* 1 for [[, which also accepts && and || */
+	int error;			/* 1 once an error has been reported */
+};
+
+static int evaluateOr(struct testParser_s *parser);
+
+
+/********************************************************************************
+ * Function name  : static int testError(struct testParser_s *parser, const char *message,
+ *										const char *argument)
+ *     returns    : 0, for the caller to return as its result
+ *         parser    : parser that found the error
+ *         message   : description of the error
+ *         argument  : argument the error is about
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : report the first error found in an expression on stderr.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int testError(struct testParser_s *parser, const char *message, const char *argument) {
+	if (!parser->error)
+		fprintf(stderr, "%s: %s: %s\n", parser->argv[0], argument, message);
+	parser->error = 1;
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int parseInteger(struct testParser_s *parser, const char *argument,
+ *											long long *value)
+ *     returns    : 1 on success, 0 if argument is not an integer
+ *         parser    : parser to report an error through
+ *         argument  : decimal integer, optionally surrounded by whitespace
+ *         value     : receives the integer
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int parseInteger(struct testParser_s *parser, const char *argument, long long *value) {
+	char *end;
+	errno = 0;
+	*value = strtoll(argument, &end, 10);
+	while (isspace((unsigned char)*end))
+		end++;
+	if (end == argument || *end != '\0' || errno == ERANGE)
+		return testError(parser, "integer expression expected", argument);
+	return 1;
+}
+
+
+/********************************************************************************
+ * Function name  : static int isBinaryOperator(const char *argument)
+ *     returns    : 1 if argument is a comparison test knows, otherwise 0
+ *         argument  : argument to check
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          : -a and -o are handled separately, as they join expressions.
+ ********************************************************************************/
+static int isBinaryOperator(const char *argument) {
+	static const char *operators[] = {
+		"=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt", "-ge", "-nt", "-ot", "-ef", NULL
+	};
+	for (int i = 0; operators[i] != NULL; i++) {
+		if (strcmp(argument, operators[i]) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int isUnaryOperator(const char *argument)
+ *     returns    : 1 if argument is a single letter predicate test knows, otherwise 0
+ *         argument  : argument to check
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int isUnaryOperator(const char *argument) {
+	return argument[0] == '-' && argument[1] != '\0' && argument[2] == '\0' &&
+		   strchr("bcdefghkLprsStuwxzGOn", argument[1]) != NULL;
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluateUnary(struct testParser_s *parser, char operator,
+ *											const char *operand)
+ *     returns    : 1 if the predicate holds, otherwise 0
+ *         parser    : parser to report an error through
+ *         operator  : letter of the predicate, as in -f
+ *         operand   : string, path or file descriptor to test
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : -z and -n test operand's length, -t whether file descriptor operand
+ *                  is a terminal, -r -w and -x whether the path is accessible, and the
+ *                  rest the type, size, mode and owner fstatat() reports for the path.
+ *
+ * NOTES          : -h and -L look at a symbolic link itself rather than its target.
+ ********************************************************************************/
+static int evaluateUnary(struct testParser_s *parser, char operator, const char *operand) {
+	struct stat statBuffer;
+	long long descriptor;
+
+	switch (operator) {
+		case 'z':
+			return operand[0] == '\0';
+		case 'n':
+			return operand[0] != '\0';
+		case 't':
+			return parseInteger(parser, operand, &descriptor) && descriptor >= 0 &&
+				   descriptor <= INT_MAX && isatty((int)descriptor);
+		case 'r':
+			return faccessat(AT_FDCWD, operand, R_OK, AT_EACCESS) == 0;
+		case 'w':
+			return faccessat(AT_FDCWD, operand, W_OK, AT_EACCESS) == 0;
+		case 'x':
+			return faccessat(AT_FDCWD, operand, X_OK, AT_EACCESS) == 0;
+	}
+
+	int flags = (operator == 'h' || operator == 'L') ? AT_SYMLINK_NOFOLLOW : 0;
+	if (fstatat(AT_FDCWD, operand, &statBuffer, flags) != 0)
+		return 0;
+	switch (operator) {
+		case 'e':	return 1;
+		case 'f':	return S_ISREG(statBuffer.st_mode);
+		case 'd':	return S_ISDIR(statBuffer.st_mode);
+		case 'b':	return S_ISBLK(statBuffer.st_mode);
+		case 'c':	return S_ISCHR(statBuffer.st_mode);
+		case 'p':	return S_ISFIFO(statBuffer.st_mode);
+		case 'S':	return S_ISSOCK(statBuffer.st_mode);
+		case 'h':
+		case 'L':	return S_ISLNK(statBuffer.st_mode);
+		case 's':	return statBuffer.st_size > 0;
+		case 'u':	return (statBuffer.st_mode & S_ISUID) != 0;
+		case 'g':	return (statBuffer.st_mode & S_ISGID) != 0;
+		case 'k':	return (statBuffer.st_mode & S_ISVTX) != 0;
+		case 'O':	return statBuffer.st_uid == geteuid();
+		case 'G':	return statBuffer.st_gid == getegid();
+	}
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluateBinary(struct testParser_s *parser, const char *left,
+ *											const char *operator, const char *right)
+ *     returns    : 1 if the comparison holds, otherwise 0
+ *         parser    : parser to report an error through
+ *         left      : left hand argument
+ *         operator  : comparison, one isBinaryOperator() accepts
+ *         right     : right hand argument
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : compare strings, integers, or the files two paths name.
+ *
+ * NOTES          : -nt and -ot compare modification times to the nanosecond. a file
+ *                  that exists is newer than one that does not.
+ ********************************************************************************/
+static int evaluateBinary(struct testParser_s *parser, const char *left, const char *operator,
+						  const char *right) {
+	if (operator[0] != '-') {
+		int order = strcmp(left, right);
+		switch (operator[0]) {
+			case '=':	return order == 0;
+			case '!':	return order != 0;
+			case '<':	return order < 0;
+			default:	return order > 0;
+		}
+	}
+
+	if (strcmp(operator, "-nt") == 0 || strcmp(operator, "-ot") == 0 || strcmp(operator, "-ef") == 0) {
+		struct stat leftStat, rightStat;
+		int leftExists = fstatat(AT_FDCWD, left, &leftStat, 0) == 0;
+		int rightExists = fstatat(AT_FDCWD, right, &rightStat, 0) == 0;
+		if (operator[1] == 'e')
+			return leftExists && rightExists && leftStat.st_dev == rightStat.st_dev &&
+				   leftStat.st_ino == rightStat.st_ino;
+		if (operator[1] == 'o') {
+			struct stat swap = leftStat;
+			int swapExists = leftExists;
+			leftStat = rightStat;
+			leftExists = rightExists;
+			rightStat = swap;
+			rightExists = swapExists;
+		}
+		if (!leftExists)
+			return 0;
+		if (!rightExists)
+			return 1;
+		return leftStat.st_mtim.tv_sec > rightStat.st_mtim.tv_sec ||
+			   (leftStat.st_mtim.tv_sec == rightStat.st_mtim.tv_sec &&
+				leftStat.st_mtim.tv_nsec > rightStat.st_mtim.tv_nsec);
+	}
+
+	long long leftValue, rightValue;
+	if (!parseInteger(parser, left, &leftValue) || !parseInteger(parser, right, &rightValue))
+		return 0;
+	if (strcmp(operator, "-eq") == 0)	return leftValue == rightValue;
+	if (strcmp(operator, "-ne") == 0)	return leftValue != rightValue;
+	if (strcmp(operator, "-lt") == 0)	return leftValue < rightValue;
+	if (strcmp(operator, "-le") == 0)	return leftValue <= rightValue;
+	if (strcmp(operator, "-gt") == 0)	return leftValue > rightValue;
+	return leftValue >= rightValue;
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluatePrimary(struct testParser_s *parser)
+ *     returns    : 1 if the condition holds, otherwise 0
+ *         parser    : parser positioned at the start of a primary
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : evaluate a comparison, a parenthesised expression, a unary
+ *                  predicate or a lone word, which is true if it is not empty.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int evaluatePrimary(struct testParser_s *parser) {
+	char **argv = parser->argv;
+	int position = parser->position;
+	if (position >= parser->end)
+		return testError(parser, "argument expected", argv[position-1]);
+
+	if (position+2 < parser->end && isBinaryOperator(argv[position+1])) {
+		parser->position += 3;
+		return evaluateBinary(parser, argv[position], argv[position+1], argv[position+2]);
+	}
+	if (strcmp(argv[position], "(") == 0 && position+1 < parser->end) {
+		parser->position++;
+		int result = evaluateOr(parser);
+		if (parser->position >= parser->end || strcmp(argv[parser->position], ")") != 0)
+			return testError(parser, "missing )", argv[parser->position-1]);
+		parser->position++;
+		return result;
+	}
+	if (isUnaryOperator(argv[position]) && position+1 < parser->end) {
+		parser->position += 2;
+		return evaluateUnary(parser, argv[position][1], argv[position+1]);
+	}
+	parser->position++;
+	return argv[position][0] != '\0';
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluateNot(struct testParser_s *parser)
+ *     returns    : 1 if the condition holds, otherwise 0
+ *         parser    : parser positioned at the start of a primary or a !
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          : a ! with nothing after it is a lone word, as in [ ! ].
+ ********************************************************************************/
+static int evaluateNot(struct testParser_s *parser) {
+	if (parser->position+1 < parser->end && strcmp(parser->argv[parser->position], "!") == 0) {
+		parser->position++;
+		return !evaluateNot(parser);
+	}
+	return evaluatePrimary(parser);
+}
+
+
+/********************************************************************************
+ * Function name  : static int isJoiningOperator(struct testParser_s *parser,
+ *												const char *operator, const char *doubled)
+ *     returns    : 1 if the next argument is operator, or doubled inside [[, otherwise 0
+ *         parser    : parser positioned after an operand
+ *         operator  : -a or -o
+ *         doubled   : && or ||
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int isJoiningOperator(struct testParser_s *parser, const char *operator, const char *doubled) {
+	if (parser->position >= parser->end)
+		return 0;
+	const char *argument = parser->argv[parser->position];
+	return strcmp(argument, operator) == 0 || (parser->doubleBracket && strcmp(argument, doubled) == 0);
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluateAnd(struct testParser_s *parser)
+ *     returns    : 1 if every condition joined by -a holds, otherwise 0
+ *         parser    : parser positioned at the start of an expression
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          : every operand is evaluated, so that errors in any are reported.
+ ********************************************************************************/
+static int evaluateAnd(struct testParser_s *parser) {
+	int result = evaluateNot(parser);
+	while (isJoiningOperator(parser, "-a", "&&")) {
+		parser->position++;
+		result = evaluateNot(parser) && result;
+	}
+	return result;
+}
+
+
+/********************************************************************************
+ * Function name  : static int evaluateOr(struct testParser_s *parser)
+ *     returns    : 1 if any condition joined by -o holds, otherwise 0
+ *         parser    : parser positioned at the start of an expression
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    :
+ *
+ * NOTES          :
+ ********************************************************************************/
+static int evaluateOr(struct testParser_s *parser) {
+	int result = evaluateAnd(parser);
+	while (isJoiningOperator(parser, "-o", "||")) {
+		parser->position++;
+		result = evaluateAnd(parser) || result;
+	}
+	return result;
+}
+
+
+/********************************************************************************
+ * Function name  : void builtin_test(int argc, char **argv, int inputFD, int outputFD)
+ *             argc  : Number of elements in argv.
+ *             argv  : Array of NULL terminated strings.
+ *			 inputFD : input pipe file descriptor. can be a valid pipe() fd or stdin.
+ *			 outputFD: output pipe file descriptor. can be a valid pipe() fd or stdout.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : evaluate the expression in argv and set builtinStatus to 0 if it
+ *                  holds, 1 if it does not and 2 if it is malformed. run as [ or [[
+ *                  the last argument must be ] or ]] respectively.
+ *
+ * NOTES          : an empty expression is false.
+ ********************************************************************************/
+void builtin_test(int argc, char **argv, int inputFD, int outputFD) {
+	struct testParser_s parser = { argv, 1, argc, strcmp(argv[0], "[[") == 0, 0 };
+	if (strcmp(argv[0], "[") == 0 || parser.doubleBracket) {
+		const char *closing = parser.doubleBracket ? "]]" : "]";
+		if (strcmp(argv[argc-1], closing) != 0) {
+			fprintf(stderr, "%s: missing %s\n", argv[0], closing);
+			builtinStatus = 2;
+			return;
+		}
+		parser.end--;
+	}
+	if (parser.end == 1) {
+		builtinStatus = 1;
+		return;
+	}
+
+	int result = evaluateOr(&parser);
+	if (parser.position < parser.end)
+		testError(&parser, "unexpected argument", argv[parser.position]);
+	builtinStatus = parser.error ? 2 : !result;
+}
@@ -0,0 +1,19 @@
+/****************************************************************************************
+ * File name	: test.h
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: The test, [ and [[ builtins. Evaluate string, integer and file conditions
+ *					without fork()ing /usr/bin/test.
+ *
+ * NOTES		:	The result is reported through builtinStatus: 0 true, 1 false and 2
+ *					for a malformed expression.
+ ****************************************************************************************/
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+void builtin_test(int argc, char **argv, int inputFD, int outputFD);
+
+#endif
@@ -0,0 +1,211 @@
+/****************************************************************************************
+ * File name	: trace.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Execution tracing into an mmap()ed ring buffer file. See trace.h for the
+ *					file layout.
+ *
+ * NOTES		:	Writing a record is an atomic add and a copy into shared memory, and
+ *					timestamps come from clock_gettime(), which does not enter the kernel
+ *					on Linux. Tracing makes no system calls of its own while commands run.
+ ****************************************************************************************/
+
+#define _GNU_SOURCE /* strdup() and O_CLOEXEC */
+
+#include "trace.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct trace_header_s *traceBuffer = NULL;
+static size_t traceMappingSize = 0;
+static char *traceFileName = NULL;
+
+
+/********************************************************************************
+ * Function name  : int traceOpen(const char *path)
+ *     returns    : zero on success, -1 on failure
+ *         path      : trace file to append to. created if it does not exist.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : map path and start tracing into it, replacing any trace file
+ *                  already open. an existing trace file keeps its capacity and
+ *                  contents. an empty file is set up with TRACE_DEFAULT_CAPACITY slots.
+ *
+ * NOTES          : refuses to overwrite a non-empty file that is not a trace file.
+ ********************************************************************************/
+int traceOpen(const char *path) {
+	struct trace_header_s header;
+	struct stat statBuffer;
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0 || fstat(fd, &statBuffer) != 0) {
+		perror("traceOpen");
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+
+	if (statBuffer.st_size == 0) {
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+		header.version = TRACE_VERSION;
+		header.recordSize = sizeof(struct trace_record_s);
+		header.capacity = TRACE_DEFAULT_CAPACITY;
+		if (ftruncate(fd, sizeof(header)+(off_t)header.capacity*sizeof(struct trace_record_s)) != 0 ||
+			pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+			perror("traceOpen");
+			close(fd);
+			return -1;
+		}
+	}
+	else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+			 memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+			 header.version != TRACE_VERSION || header.recordSize != sizeof(struct trace_record_s) ||
+			 header.capacity == 0 ||
+			 statBuffer.st_size < sizeof(header)+(off_t)header.capacity*sizeof(struct trace_record_s)) {
+		fprintf(stderr, "traceOpen: %s is not a trace file\n", path);
+		close(fd);
+		return -1;
+	}
+
+	size_t size = sizeof(header)+(size_t)header.capacity*sizeof(struct trace_record_s);
+	void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		perror("traceOpen: mmap");
+		return -1;
+	}
+	traceClose();
+	traceBuffer = mapping;
+	traceMappingSize = size;
+	traceFileName = strdup(path);
+	return 0;
+}
+
+
+/********************************************************************************
+ * Function name  : void traceClose(void)
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : stop tracing and unmap the trace file, if one is open.
+ *
+ * NOTES          : the kernel writes the shared mapping back to the file by itself.
+ ********************************************************************************/
+void traceClose(void) {
+	if (traceBuffer != NULL)
+		munmap(traceBuffer, traceMappingSize);
+	free(traceFileName);
+	traceBuffer = NULL;
+	traceMappingSize = 0;
+	traceFileName = NULL;
+}
+
+
+/********************************************************************************
+ * Function name  : const char *tracePath(void)
+ *     returns    : path of the open trace file, or NULL while tracing is off
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : report where records are going, for the set builtin.
+ *
+ * NOTES          :
+ ********************************************************************************/
+const char *tracePath(void) {
+	return traceFileName;
+}
+
+
+/********************************************************************************
+ * Function name  : uint64_t traceNow(void)
+ *     returns    : CLOCK_MONOTONIC time in nanoseconds
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : timestamp for trace records.
+ *
+ * NOTES          :
+ ********************************************************************************/
+uint64_t traceNow(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec*1000000000+now.tv_nsec;
+}
+
+
+/********************************************************************************
+ * Function name  : uint64_t traceHashArguments(int argc, char **argv)
+ *     returns    : FNV-1a 64 bit hash of argv
+ *         argc      : Number of elements in argv.
+ *         argv      : Array of NULL terminated strings.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : hash every argument including its terminator, so that "a b" and
+ *                  "ab" hash differently.
+ *
+ * NOTES          :
+ ********************************************************************************/
+uint64_t traceHashArguments(int argc, char **argv) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (int i = 0; i < argc; i++) {
+		const unsigned char *c = (const unsigned char *)argv[i];
+		do {
+			hash ^= *c;
+			hash *= 1099511628211ULL;
+		} while (*c++ != '\0');
+	}
+	return hash;
+}
+
+
+/********************************************************************************
+ * Function name  : uint64_t traceNextPipeline(void)
+ *     returns    : new pipeline id, or 0 while tracing is off
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : hand out the next pipeline id from the counter in the file header,
+ *                  so that ids stay unique between shells sharing the file.
+ *
+ * NOTES          :
+ ********************************************************************************/
+uint64_t traceNextPipeline(void) {
+	if (traceBuffer == NULL)
+		return 0;
+	return __atomic_add_fetch(&traceBuffer->pipelines, 1, __ATOMIC_RELAXED);
+}
+
+
+/********************************************************************************
+ * Function name  : void traceWrite(struct trace_record_s *record)
+ *         record    : finished record to append. its sequence field is filled in here.
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : claim the next slot of the ring and copy record into it.
+ *
+ * NOTES          : the slot's sequence is cleared first and set last, so a reader
+ *                  never mistakes a half written slot for a finished record.
+ ********************************************************************************/
+void traceWrite(struct trace_record_s *record) {
+	if (traceBuffer == NULL)
+		return;
+	uint64_t number = __atomic_fetch_add(&traceBuffer->head, 1, __ATOMIC_RELAXED);
+	struct trace_record_s *slot = (struct trace_record_s *)(traceBuffer+1)+number%traceBuffer->capacity;
+	__atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	record->sequence = 0;
+	memcpy(slot, record, sizeof(*slot));
+	__atomic_store_n(&slot->sequence, number+1, __ATOMIC_RELEASE);
+}
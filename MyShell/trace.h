@@ -0,0 +1,65 @@
+/****************************************************************************************
+ * File name	: trace.h
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Execution tracing. When enabled with set trace=<file> or the MYSHELL_TRACE
+ *					environment variable, one fixed size record per pipeline stage is
+ *					appended to a ring buffer mmap()ed from file.
+ *
+ * NOTES		:	File layout - a trace_header_s followed by header.capacity records.
+ *					record n (counting from 0 since the file was created) lives in slot
+ *					n % capacity. its sequence field is written last, as n+1, so readers can
+ *					tell finished records from ones still being written or overwritten.
+ *					All fields are in host byte order. Times are in nanoseconds.
+ *
+ *					Several shells (e.g. server mode children) may share one file.
+ ****************************************************************************************/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "MSTR"
+#define TRACE_VERSION 1
+#define TRACE_DEFAULT_CAPACITY 65536 /* records in a newly created trace file */
+
+struct trace_header_s {
+	char magic[4];			/* TRACE_MAGIC */
+	uint16_t version;		/* TRACE_VERSION */
+	uint16_t recordSize;	/* sizeof(struct trace_record_s) */
+	uint32_t capacity;		/* number of record slots after the header */
+	uint32_t reserved;
+	uint64_t head;			/* number of records ever started. updated atomically */
+	uint64_t pipelines;		/* number of pipeline ids ever handed out. updated atomically */
+	char padding[32];		/* keep the header 64 bytes long */
+};
+
+struct trace_record_s {
+	uint64_t sequence;		/* record number + 1, written last. 0 while the slot is incomplete */
+	uint64_t startTime;		/* CLOCK_MONOTONIC time the stage was launched */
+	uint64_t pipelineID;	/* unique across every shell writing to the file */
+	uint64_t argvHash;		/* FNV-1a 64 hash of the argument strings, NULL terminators included */
+	uint64_t spawnLatency;	/* time spent launching the stage, fork() included */
+	uint64_t wallTime;		/* launch until the stage was reaped */
+	uint64_t userTime, systemTime;
+	uint64_t maxRSS;		/* peak resident set size in kilobytes */
+	int32_t pid;			/* 0 for builtins run inside the shell */
+	int32_t exitStatus;		/* as lastExitStatus. 128+signal if killed */
+	uint32_t stageIndex;	/* position within the pipeline, from 0 */
+	uint32_t reserved;
+};
+
+extern struct trace_header_s *traceBuffer; /* NULL while tracing is off */
+
+int traceOpen(const char *path);
+void traceClose(void);
+const char *tracePath(void);
+uint64_t traceNow(void);
+uint64_t traceHashArguments(int argc, char **argv);
+uint64_t traceNextPipeline(void);
+void traceWrite(struct trace_record_s *record);
+
+#endif
@@ -0,0 +1,154 @@
+/****************************************************************************************
+ * File name	: tracedump.c
+ *
+ * Created by	: James Johns
+ * Date created	: 19/10/2026
+ *
+ * Description	: Decoder for MyShell trace files (see trace.h). Prints the records still
+ *					held in the ring, oldest first, as CSV, or histograms of their latencies.
+ *
+ *					usage: tracedump [-h] <trace file>
+ *
+ *					-h	print log2 histograms of wall time and spawn latency instead of CSV
+ *
+ * NOTES		:	built on its own, without the rest of the shell.
+ ****************************************************************************************/
+
+#include "trace.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HISTOGRAM_BUCKETS 40 /* 1us << 39 is far longer than any command runs */
+
+
+/********************************************************************************
+ * Function name  : static void addToHistogram(uint64_t *histogram, uint64_t nanoseconds)
+ *         histogram  : HISTOGRAM_BUCKETS counters. bucket n counts times under 2^n us.
+ *         nanoseconds: time to count
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : count nanoseconds into its power of two bucket.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static void addToHistogram(uint64_t *histogram, uint64_t nanoseconds) {
+	uint64_t microseconds = nanoseconds/1000;
+	int bucket = 0;
+	while (bucket < HISTOGRAM_BUCKETS-1 && (1ULL << bucket) <= microseconds)
+		bucket++;
+	histogram[bucket]++;
+}
+
+
+/********************************************************************************
+ * Function name  : static void printHistogram(const char *title, const uint64_t *histogram)
+ *         title     : heading to print above the histogram
+ *         histogram : counters filled by addToHistogram()
+ *
+ * Created by     : James Johns
+ * Date created   : 19/10/2026
+ * Description    : print each non-empty bucket with its count and a bar scaled to the
+ *                  largest bucket.
+ *
+ * NOTES          :
+ ********************************************************************************/
+static void printHistogram(const char *title, const uint64_t *histogram) {
+	uint64_t largest = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		if (histogram[i] > largest)
+			largest = histogram[i];
+	}
+	printf("%s\n", title);
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		if (histogram[i] == 0)
+			continue;
+		int width = (int)(histogram[i]*50/largest);
+		printf("  < %12" PRIu64 " us %10" PRIu64 " |%.*s\n", (uint64_t)1 << i, histogram[i], width,
+			   "##################################################");
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	int histograms = 0;
+	const char *path = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0)
+			histograms = 1;
+		else
+			path = argv[i];
+	}
+	if (path == NULL) {
+		fprintf(stderr, "usage: %s [-h] <trace file>\n", argv[0]);
+		return 2;
+	}
+
+	struct stat statBuffer;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &statBuffer) != 0) {
+		perror(path);
+		return 1;
+	}
+	const struct trace_header_s *header = NULL;
+	if (statBuffer.st_size >= sizeof(struct trace_header_s)) {
+		header = mmap(NULL, statBuffer.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (header == MAP_FAILED) {
+			perror("mmap");
+			return 1;
+		}
+	}
+	close(fd);
+	if (header == NULL || memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != TRACE_VERSION || header->recordSize != sizeof(struct trace_record_s) ||
+		statBuffer.st_size < sizeof(*header)+(off_t)header->capacity*sizeof(struct trace_record_s)) {
+		fprintf(stderr, "%s: not a version %d trace file\n", path, TRACE_VERSION);
+		return 1;
+	}
+
+	const struct trace_record_s *records = (const struct trace_record_s *)(header+1);
+	uint64_t head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+	uint64_t first = head > header->capacity ? head-header->capacity : 0;
+	uint64_t wallHistogram[HISTOGRAM_BUCKETS] = { 0 }, spawnHistogram[HISTOGRAM_BUCKETS] = { 0 };
+	uint64_t count = 0;
+
+	if (!histograms)
+		printf("sequence,start_ns,pipeline,stage,argv_hash,pid,spawn_ns,wall_ns,user_ns,sys_ns,max_rss_kb,exit_status\n");
+	for (uint64_t number = first; number < head; number++) {
+		struct trace_record_s record;
+		const struct trace_record_s *slot = &records[number%header->capacity];
+		/* skip slots being written, or already overwritten by a later record */
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != number+1)
+			continue;
+		memcpy(&record, slot, sizeof(record));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != number+1)
+			continue;
+		count++;
+		if (histograms) {
+			addToHistogram(wallHistogram, record.wallTime);
+			addToHistogram(spawnHistogram, record.spawnLatency);
+		}
+		else {
+			printf("%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu32 ",%016" PRIx64 ",%" PRId32 ",%" PRIu64 ",%" PRIu64
+				   ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRId32 "\n",
+				   record.sequence, record.startTime, record.pipelineID, record.stageIndex, record.argvHash,
+				   record.pid, record.spawnLatency, record.wallTime, record.userTime, record.systemTime,
+				   record.maxRSS, record.exitStatus);
+		}
+	}
+	if (histograms) {
+		printf("%" PRIu64 " records\n\n", count);
+		printHistogram("wall time", wallHistogram);
+		printf("\n");
+		printHistogram("spawn latency", spawnHistogram);
+	}
+	return 0;
+}